@@ -34,6 +34,7 @@
 
 #define REG_L		__REG_SEL(ld, lw)
 #define REG_S		__REG_SEL(sd, sw)
+#define REG_LR		__REG_SEL(lr.d, lr.w)
 #define SZREG		__REG_SEL(8, 4)
 #define LGREG		__REG_SEL(3, 2)
 
@@ -187,9 +188,22 @@ int pmp_disable(unsigned int n);
 /* Check if the matching field is set */
 int is_pmp_entry_mapped(unsigned long entry);
 
+/* Encode pmpcfg byte and pmpaddr value of a NA4/NAPOT pmp entry */
+int pmp_encode(unsigned long prot, unsigned long addr, unsigned long log2len,
+	       unsigned long *cfg_out, unsigned long *pmpaddr_out);
+
+/* Write already encoded pmpcfg byte and pmpaddr value of pmp entry */
+int pmp_set_raw(unsigned int n, unsigned long cfg, unsigned long pmpaddr);
+
 int pmp_set(unsigned int n, unsigned long prot, unsigned long addr,
 	    unsigned long log2len);
 
+/* Write pmpaddr CSRs of first count pmp entries */
+void pmpaddr_write_all(const unsigned long *pmpaddr, unsigned int count);
+
+/* Write packed pmpcfg CSRs covering first count pmp entries */
+void pmpcfg_write_all(const unsigned long *pmpcfg, unsigned int count);
+
 int pmp_get(unsigned int n, unsigned long *prot_out, unsigned long *addr_out,
 	    unsigned long *log2len);
 
@@ -151,6 +151,8 @@
 
 #define PMP_SHIFT			2
 #define PMP_COUNT			64
+#define PMP_CFG_PER_REG			(__riscv_xlen / 8)
+#define PMP_CFG_REG_COUNT		(PMP_COUNT / PMP_CFG_PER_REG)
 #if __riscv_xlen == 64
 #define PMP_ADDR_MASK			((_ULL(0x1) << 54) - 1)
 #else
@@ -385,6 +387,10 @@
 #define CSR_VSIP			0x244
 #define CSR_VSATP			0x280
 
+/* Virtual Supervisor Timer Compare (Sstc) */
+#define CSR_VSTIMECMP			0x24D
+#define CSR_VSTIMECMPH			0x25D
+
 /* Virtual Interrupts and Interrupt Priorities (H-extension with AIA) */
 #define CSR_HVIEN			0x608
 #define CSR_HVICTL			0x609
@@ -0,0 +1,97 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Copyright (c) 2026 OpenSBI contributors.
+ */
+
+#ifndef __SBI_BOOT_PROF_H__
+#define __SBI_BOOT_PROF_H__
+
+#include <sbi/sbi_error.h>
+#include <sbi/sbi_types.h>
+
+/* clang-format off */
+
+/** Magic value of the boot profile export header ("SBBP") */
+#define SBI_BOOT_PROF_MAGIC		0x50424253
+
+/* clang-format on */
+
+/**
+ * Cold boot phases. The value recorded for a phase is the MCYCLE
+ * value at the end of that phase. The first five phases are recorded
+ * by fw_base.S before the C runtime is set up.
+ */
+enum sbi_boot_phase {
+	SBI_BOOT_PHASE_FW_ENTRY = 0,
+	SBI_BOOT_PHASE_RELOCATE,
+	SBI_BOOT_PHASE_BSS_ZERO,
+	SBI_BOOT_PHASE_FW_SCRATCH,
+	SBI_BOOT_PHASE_FDT_RELOCATE,
+	SBI_BOOT_PHASE_SBI_ENTRY,
+	SBI_BOOT_PHASE_SCRATCH,
+	SBI_BOOT_PHASE_HEAP,
+	SBI_BOOT_PHASE_DOMAIN,
+	SBI_BOOT_PHASE_TRACE,
+	SBI_BOOT_PHASE_HSM,
+	SBI_BOOT_PHASE_PLATFORM_EARLY,
+	SBI_BOOT_PHASE_HART,
+	SBI_BOOT_PHASE_CONSOLE,
+	SBI_BOOT_PHASE_PMU,
+	SBI_BOOT_PHASE_DBTR,
+	SBI_BOOT_PHASE_BANNER,
+	SBI_BOOT_PHASE_IRQCHIP,
+	SBI_BOOT_PHASE_CONSOLE_IRQ,
+	SBI_BOOT_PHASE_IPI,
+	SBI_BOOT_PHASE_TLB,
+	SBI_BOOT_PHASE_TIMER,
+	SBI_BOOT_PHASE_DOMAIN_FINALIZE,
+	SBI_BOOT_PHASE_PLATFORM_FINAL,
+	SBI_BOOT_PHASE_ECALL,
+	SBI_BOOT_PHASE_BOOT_PRINTS,
+	SBI_BOOT_PHASE_PMP,
+	SBI_BOOT_PHASE_MAX,
+};
+
+/** Number of phases recorded by fw_base.S */
+#define SBI_BOOT_PHASE_FW_COUNT		(SBI_BOOT_PHASE_SBI_ENTRY)
+
+/** Header of the boot profile export */
+struct sbi_boot_prof_header {
+	/** Always SBI_BOOT_PROF_MAGIC */
+	u32 magic;
+	/** Number of u64 MCYCLE values following the header */
+	u32 count;
+};
+
+struct sbi_scratch;
+
+#ifdef CONFIG_SBI_BOOT_PROFILE
+
+/** Record the end of a cold boot phase */
+void sbi_boot_prof_mark(enum sbi_boot_phase phase);
+
+/** Print the cold boot profile on the console */
+void sbi_boot_prof_print(struct sbi_scratch *scratch);
+
+/**
+ * Copy the cold boot profile to a buffer aligned to 8 bytes
+ *
+ * @return number of bytes written or negative error code
+ */
+int sbi_boot_prof_read(void *buf, unsigned long size);
+
+#else
+
+static inline void sbi_boot_prof_mark(enum sbi_boot_phase phase) { }
+
+static inline void sbi_boot_prof_print(struct sbi_scratch *scratch) { }
+
+static inline int sbi_boot_prof_read(void *buf, unsigned long size)
+{
+	return SBI_ENOTSUPP;
+}
+
+#endif
+
+#endif
@@ -24,6 +24,15 @@ struct sbi_console_device {
 
 	/** Read a character from the console input */
 	int (*console_getc)(void);
+
+	/**
+	 * Write characters to the console output without waiting and
+	 * return the number of characters written (interrupt mode)
+	 */
+	unsigned long (*console_tx_fill)(const char *str, unsigned long len);
+
+	/** Enable or disable the TX ready and RX ready interrupts */
+	void (*console_irq_enable)(bool tx, bool rx);
 };
 
 #define __printf(a, b) __attribute__((format(printf, a, b)))
@@ -60,6 +69,27 @@ struct sbi_scratch;
 
 int sbi_console_init(struct sbi_scratch *scratch);
 
+#ifdef CONFIG_SBI_CONSOLE_IRQ
+
+void sbi_console_set_irq(u32 hwirq);
+
+int sbi_console_irq_init(struct sbi_scratch *scratch);
+
+void sbi_console_exit(struct sbi_scratch *scratch);
+
+#else
+
+static inline void sbi_console_set_irq(u32 hwirq) { }
+
+static inline int sbi_console_irq_init(struct sbi_scratch *scratch)
+{
+	return 0;
+}
+
+static inline void sbi_console_exit(struct sbi_scratch *scratch) { }
+
+#endif
+
 #define SBI_ASSERT(cond, args) do { \
 	if (unlikely(!(cond))) \
 		sbi_panic args; \
@@ -13,6 +13,7 @@
 #include <sbi/sbi_types.h>
 #include <sbi/sbi_hartmask.h>
 
+struct sbi_hart_pmp_image;
 struct sbi_scratch;
 
 /** Domain access types */
@@ -156,6 +157,16 @@ struct sbi_domain_memregion {
 	unsigned long flags;
 };
 
+/** Address span which resolves to a single (most specific) memregion */
+struct sbi_domain_memspan {
+	/** First address of the span */
+	unsigned long start;
+	/** Last address of the span */
+	unsigned long end;
+	/** Memory region which applies to all addresses of the span */
+	const struct sbi_domain_memregion *reg;
+};
+
 /** Maximum number of domains */
 #define SBI_DOMAIN_MAX_INDEX			32
 
@@ -190,8 +201,22 @@ struct sbi_domain {
 	bool system_reset_allowed;
 	/** Is domain allowed to suspend the system */
 	bool system_suspend_allowed;
+	/** Indexes of domains allowed to switch HARTs into this domain */
+	DECLARE_BITMAP(switch_from, SBI_DOMAIN_MAX_INDEX);
 	/** Identifies whether to include the firmware region */
 	bool fw_region_inited;
+	/**
+	 * Sorted non-overlapping spans covering the memory regions
+	 * Note: This set by sbi_domain_finalize() in the coldboot path
+	 */
+	struct sbi_domain_memspan *spans;
+	/** Number of entries in spans */
+	u32 span_count;
+	/**
+	 * Precomputed PMP entries of the domain
+	 * Note: This set by sbi_domain_finalize() in the coldboot path
+	 */
+	struct sbi_hart_pmp_image *pmp_image;
 };
 
 /** The root domain instance */
@@ -295,6 +320,52 @@ void sbi_domain_dump_all(const char *suffix);
 int sbi_domain_register(struct sbi_domain *dom,
 			const struct sbi_hartmask *assign_mask);
 
+/**
+ * Allow HARTs running in a domain to switch into another domain
+ * @param dom pointer to the domain which is switched into
+ * @param from pointer to the domain which may request the switch
+ *
+ * @return 0 on success
+ * @return SBI_EINVAL if domains are already finalized
+ */
+int sbi_domain_allow_switch(struct sbi_domain *dom,
+			    const struct sbi_domain *from);
+
+/**
+ * Check whether a HART running in a domain may switch into another one
+ *
+ * The HART must be a possible HART of the target domain, and the target
+ * domain must either be the domain the HART is assigned to or allow
+ * switches from the current domain.
+ *
+ * @param dom pointer to the target domain
+ * @param from pointer to the domain the HART currently runs in
+ * @param hartindex the HART index
+ */
+bool sbi_domain_switch_allowed(const struct sbi_domain *dom,
+			       const struct sbi_domain *from, u32 hartindex);
+
+/**
+ * Change the domain a HART runs in
+ *
+ * The HART stays assigned to its domain so IPIs, remote fences and HSM
+ * calls of that domain still reach it. Only the memory regions and
+ * permissions used for the HART follow the new domain.
+ *
+ * @param hartindex the HART index
+ * @param dom pointer to the domain the HART runs in from now on
+ *
+ * @return 0 on success
+ * @return SBI_EINVAL if the HART is not a possible HART of the domain
+ */
+int sbi_domain_switch_hart(u32 hartindex, struct sbi_domain *dom);
+
+/**
+ * Make a HART run in the domain it is assigned to again
+ * @param hartindex the HART index
+ */
+void sbi_domain_reset_hart(u32 hartindex);
+
 /**
  * Add a memory region to the root domain
  * @param reg pointer to the memory region to be added
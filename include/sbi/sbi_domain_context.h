@@ -0,0 +1,55 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Copyright (c) 2026 OpenSBI contributors.
+ */
+
+#ifndef __SBI_DOMAIN_CONTEXT_H__
+#define __SBI_DOMAIN_CONTEXT_H__
+
+#include <sbi/sbi_error.h>
+#include <sbi/sbi_types.h>
+
+struct sbi_domain;
+struct sbi_trap_regs;
+
+#ifdef CONFIG_SBI_DOMAIN_CONTEXT
+
+/**
+ * Switch the current HART to another domain
+ *
+ * The S/U-mode context of the current domain is saved from the trap
+ * registers, FP registers, S-mode, Sstc and H-extension CSRs of the
+ * HART. The context of the target domain is restored into them, or set
+ * up to enter the next booting stage of the target domain if the domain
+ * never ran on this HART. Only the PMP entries which differ between both
+ * domains are rewritten.
+ *
+ * On failure the HART, its PMP and @p regs are left as they were.
+ *
+ * @param regs trap registers which are restored on trap return
+ * @param dom pointer to the target domain
+ *
+ * @return 0 on success, SBI_EDENIED if the target domain does not allow
+ * switches from the current domain, if the vector unit is in use or if
+ * a locked PMP entry would need to change, or other negative error code
+ */
+int sbi_domain_context_switch(struct sbi_trap_regs *regs,
+			      struct sbi_domain *dom);
+
+/** Initialize domain context switching */
+int sbi_domain_context_init(void);
+
+#else
+
+static inline int sbi_domain_context_switch(struct sbi_trap_regs *regs,
+					    struct sbi_domain *dom)
+{
+	return SBI_ENOTSUPP;
+}
+
+static inline int sbi_domain_context_init(void) { return 0; }
+
+#endif
+
+#endif
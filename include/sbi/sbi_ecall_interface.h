@@ -33,6 +33,7 @@
 #define SBI_EXT_SUSP				0x53555350
 #define SBI_EXT_CPPC				0x43505043
 #define SBI_EXT_DBTR				0x44425452
+#define SBI_EXT_OPENSBI				0x0A000001
 
 /* SBI function IDs for BASE extension*/
 #define SBI_EXT_BASE_GET_SPEC_VERSION		0x0
@@ -116,6 +117,13 @@
 #define SBI_EXT_DBTR_TRIGGER_ENABLE	0x6
 #define SBI_EXT_DBTR_TRIGGER_DISABLE	0x7
 
+/* SBI function IDs for OpenSBI firmware-specific extension */
+#define SBI_EXT_OPENSBI_TRACE_READ	0x0
+#define SBI_EXT_OPENSBI_DOMAIN_SWITCH	0x1
+#define SBI_EXT_OPENSBI_HSM_HART_START_MANY	0x2
+#define SBI_EXT_OPENSBI_HSM_STATS_DUMP	0x3
+#define SBI_EXT_OPENSBI_BOOT_PROFILE_READ	0x4
+
 /** General pmu event codes specified in SBI PMU extension */
 enum sbi_pmu_hw_generic_events_t {
 	SBI_PMU_HW_NO_EVENT			= 0,
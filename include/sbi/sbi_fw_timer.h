@@ -0,0 +1,87 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Copyright (c) 2026 OpenSBI contributors.
+ */
+
+#ifndef __SBI_FW_TIMER_H__
+#define __SBI_FW_TIMER_H__
+
+#include <sbi/sbi_error.h>
+#include <sbi/sbi_types.h>
+
+/** Firmware timer of a HART */
+struct sbi_fw_timer {
+	/** Expiry time in timer ticks */
+	u64 expires;
+	/** Ticks by which expiry may be delayed to share an interrupt */
+	u64 slack;
+	/** Called in M-mode trap context on the HART which added the timer */
+	void (*fn)(struct sbi_fw_timer *timer);
+	/** Position in the HART timer queue (private) */
+	u32 index;
+};
+
+struct sbi_scratch;
+
+#ifdef CONFIG_SBI_FW_TIMER
+
+/**
+ * Add or re-arm a firmware timer on the current HART
+ *
+ * The timer fires once at or after @p expires and no later than
+ * @p expires + @p slack ticks, together with any other timer or S-mode
+ * timer event which falls in that window. The callback may re-add the
+ * timer to make it periodic.
+ *
+ * @return 0 on success, SBI_ENOSPC if the queue is full or
+ * SBI_ENOTSUPP if the timer device cannot raise M-mode timer interrupts
+ */
+int sbi_fw_timer_add(struct sbi_fw_timer *timer, u64 expires, u64 slack);
+
+/** Cancel a firmware timer added on the current HART */
+void sbi_fw_timer_cancel(struct sbi_fw_timer *timer);
+
+/** Check whether a firmware timer is queued on the current HART */
+bool sbi_fw_timer_pending(struct sbi_fw_timer *timer);
+
+/** Latest time by which the next firmware timer of a HART must fire */
+u64 sbi_fw_timer_next(struct sbi_scratch *scratch);
+
+/** Run the expired firmware timers of a HART */
+void sbi_fw_timer_process(struct sbi_scratch *scratch, u64 now);
+
+int sbi_fw_timer_init(struct sbi_scratch *scratch, bool cold_boot);
+
+#else
+
+static inline int sbi_fw_timer_add(struct sbi_fw_timer *timer, u64 expires,
+				   u64 slack)
+{
+	return SBI_ENOTSUPP;
+}
+
+static inline void sbi_fw_timer_cancel(struct sbi_fw_timer *timer) { }
+
+static inline bool sbi_fw_timer_pending(struct sbi_fw_timer *timer)
+{
+	return false;
+}
+
+static inline u64 sbi_fw_timer_next(struct sbi_scratch *scratch)
+{
+	return -1ULL;
+}
+
+static inline void sbi_fw_timer_process(struct sbi_scratch *scratch,
+					u64 now) { }
+
+static inline int sbi_fw_timer_init(struct sbi_scratch *scratch,
+				    bool cold_boot)
+{
+	return 0;
+}
+
+#endif
+
+#endif
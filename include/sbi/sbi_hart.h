@@ -10,6 +10,7 @@
 #ifndef __SBI_HART_H__
 #define __SBI_HART_H__
 
+#include <sbi/riscv_encoding.h>
 #include <sbi/sbi_types.h>
 #include <sbi/sbi_bitops.h>
 
@@ -55,6 +56,8 @@ enum sbi_hart_extensions {
 	SBI_HART_EXT_SVPBMT,
 	/** Hart has debug trigger extension */
 	SBI_HART_EXT_SDTRIG,
+	/** Hart has Zawrs extension */
+	SBI_HART_EXT_ZAWRS,
 
 	/** Maximum index of Hart extension */
 	SBI_HART_EXT_MAX,
@@ -78,7 +81,12 @@ extern const struct sbi_hart_ext_data sbi_hart_ext[];
  * should be programmed into the first PMP entry with R/W
  * permissions to the M-mode. Once the work is done, it should be
  * unmapped. sbi_hart_map_saddr/sbi_hart_unmap_saddr function
- * pair should be used to map/unmap the shared memory.
+ * pair should be used to map/unmap the shared memory. If the
+ * domain already grants S-mode read/write and no execute access to
+ * the whole NAPOT window, the entry is left programmed on unmap so
+ * that repeated accesses to the same shared memory do not reprogram
+ * it. Otherwise it is disabled on unmap. The cached window is dropped
+ * whenever the PMP entries are reconfigured or switched.
  */
 #define SBI_SMEPMP_RESV_ENTRY		0
 
@@ -93,10 +101,33 @@ struct sbi_hart_features {
 	unsigned int mhpm_bits;
 };
 
+/** Precomputed PMP entries of a domain */
+struct sbi_hart_pmp_image {
+	/** Number of PMP entries the image was computed for */
+	unsigned int pmp_count;
+	/** PMP granularity the image was computed for */
+	unsigned int pmp_log2gran;
+	/** PMP address bits the image was computed for */
+	unsigned int pmp_addr_bits;
+	/** Whether the image uses Smepmp encoding */
+	bool smepmp;
+	/** One more than the index of the last enabled entry */
+	unsigned int used;
+	/** Packed pmpcfg register values */
+	unsigned long cfg[PMP_CFG_REG_COUNT];
+	/** Packed pmpcfg register values with only M-only entries (Smepmp) */
+	unsigned long mcfg[PMP_CFG_REG_COUNT];
+	/** Encoded pmpaddr value of each entry */
+	unsigned long addr[PMP_COUNT];
+};
+
+struct sbi_domain;
 struct sbi_scratch;
 
 int sbi_hart_reinit(struct sbi_scratch *scratch);
 int sbi_hart_init(struct sbi_scratch *scratch, bool cold_boot);
+void sbi_hart_resume_save(struct sbi_scratch *scratch);
+int sbi_hart_resume_restore(struct sbi_scratch *scratch);
 
 extern void (*sbi_hart_expected_trap)(void);
 static inline ulong sbi_hart_expected_trap_addr(void)
@@ -112,6 +143,13 @@ unsigned int sbi_hart_pmp_log2gran(struct sbi_scratch *scratch);
 unsigned int sbi_hart_pmp_addrbits(struct sbi_scratch *scratch);
 unsigned int sbi_hart_mhpm_bits(struct sbi_scratch *scratch);
 int sbi_hart_pmp_configure(struct sbi_scratch *scratch);
+int sbi_hart_pmp_image_build(struct sbi_scratch *scratch,
+			     const struct sbi_domain *dom,
+			     struct sbi_hart_pmp_image *img);
+int sbi_hart_pmp_switch(struct sbi_scratch *scratch,
+			const struct sbi_hart_pmp_image *from,
+			const struct sbi_hart_pmp_image *to);
+void sbi_hart_saddr_invalidate(struct sbi_scratch *scratch);
 int sbi_hart_map_saddr(unsigned long base, unsigned long size);
 int sbi_hart_unmap_saddr(void);
 int sbi_hart_priv_version(struct sbi_scratch *scratch);
@@ -125,6 +163,14 @@ bool sbi_hart_has_extension(struct sbi_scratch *scratch,
 void sbi_hart_get_extensions_str(struct sbi_scratch *scratch,
 				 char *extension_str, int nestr);
 
+bool sbi_hart_can_wait_on_addr(void);
+void __sbi_hart_wait_on_u32(volatile u32 *addr, u32 val, bool timeout);
+void __sbi_hart_wait_on_ulong(volatile unsigned long *addr,
+			      unsigned long val, bool timeout);
+bool sbi_hart_wait_on_u32(volatile u32 *addr, u32 val, bool timeout);
+bool sbi_hart_wait_on_ulong(volatile unsigned long *addr, unsigned long val,
+			    bool timeout);
+
 void __attribute__((noreturn)) sbi_hart_hang(void);
 
 void __attribute__((noreturn))
@@ -64,6 +64,10 @@ void __noreturn sbi_hsm_exit(struct sbi_scratch *scratch);
 int sbi_hsm_hart_start(struct sbi_scratch *scratch,
 		       const struct sbi_domain *dom,
 		       u32 hartid, ulong saddr, ulong smode, ulong arg1);
+int sbi_hsm_hart_start_many(struct sbi_scratch *scratch,
+			    const struct sbi_domain *dom,
+			    ulong hmask, ulong hbase,
+			    ulong saddr, ulong smode, ulong arg1);
 int sbi_hsm_hart_stop(struct sbi_scratch *scratch, bool exitnow);
 void sbi_hsm_hart_resume_start(struct sbi_scratch *scratch);
 void __noreturn sbi_hsm_hart_resume_finish(struct sbi_scratch *scratch,
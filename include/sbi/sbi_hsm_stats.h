@@ -0,0 +1,91 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Copyright (c) 2026 OpenSBI contributors.
+ */
+
+#ifndef __SBI_HSM_STATS_H__
+#define __SBI_HSM_STATS_H__
+
+#include <sbi/sbi_error.h>
+#include <sbi/sbi_types.h>
+
+/** Maximum number of suspend types tracked per HART */
+#define SBI_HSM_STATS_MAX_TYPES		8
+
+/** Suspend statistics of one suspend type on a HART */
+struct sbi_hsm_suspend_stats {
+	/** Suspend type entered */
+	u32 suspend_type;
+	/** Number of times the suspend type was entered */
+	u64 entries;
+	/** Total time spent suspended in timer ticks */
+	u64 residency;
+	/** Wakeups before the timer event pending at suspend entry */
+	u64 early_wakes;
+	/** Number of exit latency samples */
+	u64 exits;
+	/** Total, minimum and maximum exit latency in timer ticks */
+	u64 exit_latency;
+	u64 exit_latency_min;
+	u64 exit_latency_max;
+};
+
+struct sbi_domain;
+struct sbi_scratch;
+
+#ifdef CONFIG_SBI_HSM_STATS
+
+/** Note that the current HART is about to enter a suspend type */
+void sbi_hsm_stats_suspend_enter(struct sbi_scratch *scratch,
+				 u32 suspend_type);
+
+/** Drop the suspend noted by sbi_hsm_stats_suspend_enter() */
+void sbi_hsm_stats_suspend_abort(struct sbi_scratch *scratch);
+
+/** Note that the current HART woke up and started resuming */
+void sbi_hsm_stats_resume_start(struct sbi_scratch *scratch);
+
+/** Note that the current HART is about to return to the caller */
+void sbi_hsm_stats_resume_finish(struct sbi_scratch *scratch);
+
+/** Get the suspend statistics of a HART for a suspend type */
+const struct sbi_hsm_suspend_stats *sbi_hsm_stats_get(u32 hartindex,
+						      u32 suspend_type);
+
+/** Print the suspend statistics of the HARTs assigned to a domain */
+int sbi_hsm_stats_dump(const struct sbi_domain *dom);
+
+int sbi_hsm_stats_init(struct sbi_scratch *scratch, bool cold_boot);
+
+#else
+
+static inline void sbi_hsm_stats_suspend_enter(struct sbi_scratch *scratch,
+					       u32 suspend_type) { }
+
+static inline void sbi_hsm_stats_suspend_abort(struct sbi_scratch *scratch) { }
+
+static inline void sbi_hsm_stats_resume_start(struct sbi_scratch *scratch) { }
+
+static inline void sbi_hsm_stats_resume_finish(struct sbi_scratch *scratch) { }
+
+static inline const struct sbi_hsm_suspend_stats *sbi_hsm_stats_get(
+						u32 hartindex, u32 suspend_type)
+{
+	return NULL;
+}
+
+static inline int sbi_hsm_stats_dump(const struct sbi_domain *dom)
+{
+	return SBI_ENOTSUPP;
+}
+
+static inline int sbi_hsm_stats_init(struct sbi_scratch *scratch,
+				     bool cold_boot)
+{
+	return 0;
+}
+
+#endif
+
+#endif
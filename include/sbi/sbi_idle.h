@@ -0,0 +1,99 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Copyright (c) 2026 OpenSBI contributors.
+ */
+
+#ifndef __SBI_IDLE_H__
+#define __SBI_IDLE_H__
+
+#include <sbi/sbi_types.h>
+
+/** Maximum number of idle states known to the idle governor */
+#define SBI_IDLE_MAX_STATES		8
+
+/** Idle state as described by the riscv,idle-state DT binding */
+struct sbi_idle_state {
+	/** SBI HSM suspend type used to enter the state */
+	u32 suspend_type;
+	/** Worst case exit latency in microseconds */
+	u32 exit_latency_us;
+	/** Minimum residency for the state to save power in microseconds */
+	u32 min_residency_us;
+};
+
+/** Idle governor statistics of a HART */
+struct sbi_idle_stats {
+	/** Requests entered in a shallower state than asked for */
+	unsigned long demoted;
+	/** Requests entered in a deeper state than asked for */
+	unsigned long promoted;
+	/** Wakeups before the minimum residency of the entered state */
+	unsigned long too_deep;
+	/** Demoted requests which slept long enough for the asked state */
+	unsigned long too_shallow;
+};
+
+struct sbi_scratch;
+
+#ifdef CONFIG_SBI_IDLE_GOVERNOR
+
+/** Register an idle state with the idle governor */
+int sbi_idle_state_register(const struct sbi_idle_state *state);
+
+/**
+ * Select the suspend type to enter for a HSM suspend request
+ *
+ * The selection is based on the time until the next timer event of
+ * the HART. A retentive request is never turned into a non-retentive
+ * one and the exit latency of the requested state is never exceeded.
+ *
+ * @param scratch pointer to the HART scratch space
+ * @param suspend_type suspend type requested by S-mode
+ *
+ * @return the suspend type to enter
+ */
+u32 sbi_idle_select(struct sbi_scratch *scratch, u32 suspend_type);
+
+/** Note that the requested state is entered because the selected one failed */
+void sbi_idle_fallback(struct sbi_scratch *scratch);
+
+/** Account the end of an idle period entered after sbi_idle_select() */
+void sbi_idle_exit(struct sbi_scratch *scratch);
+
+/** Get idle governor statistics of a HART */
+const struct sbi_idle_stats *sbi_idle_get_stats(struct sbi_scratch *scratch);
+
+int sbi_idle_init(struct sbi_scratch *scratch, bool cold_boot);
+
+#else
+
+static inline int sbi_idle_state_register(const struct sbi_idle_state *state)
+{
+	return 0;
+}
+
+static inline u32 sbi_idle_select(struct sbi_scratch *scratch,
+				  u32 suspend_type)
+{
+	return suspend_type;
+}
+
+static inline void sbi_idle_fallback(struct sbi_scratch *scratch) { }
+
+static inline void sbi_idle_exit(struct sbi_scratch *scratch) { }
+
+static inline const struct sbi_idle_stats *sbi_idle_get_stats(
+						struct sbi_scratch *scratch)
+{
+	return NULL;
+}
+
+static inline int sbi_idle_init(struct sbi_scratch *scratch, bool cold_boot)
+{
+	return 0;
+}
+
+#endif
+
+#endif
@@ -36,6 +36,7 @@ enum sbi_ipi_update_type {
 	SBI_IPI_UPDATE_RETRY,
 };
 
+struct sbi_hartmask;
 struct sbi_scratch;
 
 /** IPI event operations or callbacks */
@@ -87,6 +88,8 @@ void sbi_ipi_process(void);
 
 int sbi_ipi_raw_send(u32 hartindex);
 
+int sbi_ipi_raw_send_many(const struct sbi_hartmask *mask);
+
 void sbi_ipi_raw_clear(u32 hartindex);
 
 const struct sbi_ipi_device *sbi_ipi_get_device(void);
@@ -25,6 +25,56 @@ struct sbi_trap_regs;
  */
 void sbi_irqchip_set_irqfn(int (*fn)(struct sbi_trap_regs *regs));
 
+/**
+ * Set external interrupt routing function
+ *
+ * This function is called by OpenSBI platform code to set a function
+ * which enables or disables delivery of an external interrupt source
+ * to M-mode of the current HART
+ *
+ * @param fn function pointer for routing external irqs
+ */
+void sbi_irqchip_set_routefn(int (*fn)(u32 hwirq, bool enable));
+
+/**
+ * Register M-mode handler for an external interrupt source
+ *
+ * The interrupt source is routed to M-mode of the current HART.
+ *
+ * @param hwirq external interrupt source number
+ * @param fn handler function pointer
+ * @param priv private data passed to the handler
+ *
+ * @return 0 on success and negative error code on failure
+ */
+int sbi_irqchip_register_handler(u32 hwirq,
+				 int (*fn)(u32 hwirq, void *priv), void *priv);
+
+/**
+ * Unregister M-mode handler of an external interrupt source
+ *
+ * @param hwirq external interrupt source number
+ */
+void sbi_irqchip_unregister_handler(u32 hwirq);
+
+/**
+ * Route again the external interrupt sources of the current HART
+ *
+ * This function is called after the irqchip state of the current HART
+ * was reset, such as by irqchip warm init or by a non-retentive suspend,
+ * so that registered handlers keep receiving their interrupts.
+ */
+void sbi_irqchip_reroute(void);
+
+/**
+ * Process an external interrupt source claimed by the irqchip driver
+ *
+ * @param hwirq external interrupt source number
+ *
+ * @return 0 on success and negative error code on failure
+ */
+int sbi_irqchip_process_hwirq(u32 hwirq);
+
 /**
  * Process external interrupts
  *
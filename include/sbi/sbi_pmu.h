@@ -10,6 +10,7 @@
 #ifndef __SBI_PMU_H__
 #define __SBI_PMU_H__
 
+#include <sbi/riscv_asm.h>
 #include <sbi/sbi_types.h>
 
 struct sbi_scratch;
@@ -22,6 +23,42 @@ struct sbi_scratch;
 #define SBI_PMU_FW_CTR_MAX 16
 #define SBI_PMU_HW_CTR_MAX 32
 #define SBI_PMU_CTR_MAX	   (SBI_PMU_HW_CTR_MAX + SBI_PMU_FW_CTR_MAX)
+
+/**
+ * OpenSBI specific firmware events which accumulate the number of M-mode
+ * cycles spent in OpenSBI instead of counting occurrences. They use the
+ * top of the reserved firmware event code range. The HSM suspend events
+ * accumulate timer ticks or count suspend entries and early wakeups.
+ */
+enum sbi_pmu_fw_residency_id {
+	SBI_PMU_FW_RES_TRAP		= 0xFF00,
+	SBI_PMU_FW_RES_ECALL		= 0xFF01,
+	SBI_PMU_FW_RES_IPI		= 0xFF02,
+	SBI_PMU_FW_RES_TLB		= 0xFF03,
+	SBI_PMU_FW_RES_MISALIGNED	= 0xFF04,
+	SBI_PMU_FW_RES_ILLEGAL_INSN	= 0xFF05,
+	SBI_PMU_FW_RES_CONSOLE		= 0xFF06,
+	SBI_PMU_FW_RES_SUSPEND		= 0xFF07,
+	SBI_PMU_FW_RES_RESUME		= 0xFF08,
+	SBI_PMU_FW_HSM_SUSPEND		= 0xFF09,
+	SBI_PMU_FW_HSM_EARLY_WAKE	= 0xFF0A,
+	SBI_PMU_FW_RES_MAX,
+};
+
+#define SBI_PMU_FW_RES_BASE	SBI_PMU_FW_RES_TRAP
+#define SBI_PMU_FW_RES_COUNT	(SBI_PMU_FW_RES_MAX - SBI_PMU_FW_RES_BASE)
+
+/** Size and alignment of the PMU snapshot shared memory */
+#define SBI_PMU_SNAPSHOT_SHMEM_SIZE	4096
+
+/** Layout of the PMU snapshot shared memory as per SBI specification */
+struct sbi_pmu_snapshot {
+	/* Overflowed counters relative to counter_idx_base */
+	uint64_t ctr_overflow_mask;
+	/* Counter values relative to counter_idx_base */
+	uint64_t ctr_values[64];
+	uint64_t reserved[447];
+};
 #define SBI_PMU_FIXED_CTR_MASK 0x07
 #define SBI_PMU_CY_IR_MASK	0x05
 
@@ -150,4 +187,39 @@ int sbi_pmu_ctr_cfg_match(unsigned long cidx_base, unsigned long cidx_mask,
 
 int sbi_pmu_ctr_incr_fw(enum sbi_pmu_fw_event_code_id fw_id);
 
+#ifdef CONFIG_SBI_PMU_FW_RESIDENCY
+
+int sbi_pmu_ctr_add_fw(uint32_t fw_id, uint64_t val);
+
+/** Start measuring M-mode residency, returns the current cycle count */
+static inline unsigned long sbi_pmu_residency_start(void)
+{
+	return csr_read(CSR_MCYCLE);
+}
+
+/** Account the cycles since sbi_pmu_residency_start() to a residency event */
+static inline void sbi_pmu_residency_end(enum sbi_pmu_fw_residency_id res_id,
+					 unsigned long start)
+{
+	sbi_pmu_ctr_add_fw(res_id, csr_read(CSR_MCYCLE) - start);
+}
+
+#else
+
+static inline int sbi_pmu_ctr_add_fw(uint32_t fw_id, uint64_t val)
+{
+	return 0;
+}
+
+static inline unsigned long sbi_pmu_residency_start(void) { return 0; }
+
+static inline void sbi_pmu_residency_end(enum sbi_pmu_fw_residency_id res_id,
+					 unsigned long start) { }
+
+#endif
+
+int sbi_pmu_snapshot_set_shmem(unsigned long shmem_phys_lo,
+			       unsigned long shmem_phys_hi,
+			       unsigned long flags);
+
 #endif
@@ -84,6 +84,12 @@ void sbi_timer_set_delta_upper(ulong delta_upper);
 /** Start timer event for current HART */
 void sbi_timer_event_start(u64 next_event);
 
+/** Get next timer event of current HART (-1ULL if none pending) */
+u64 sbi_timer_next_event(void);
+
+/** Reprogram timer for the next S-mode or firmware timer of current HART */
+void sbi_timer_rearm(void);
+
 /** Process timer event for current HART */
 void sbi_timer_process(void);
 
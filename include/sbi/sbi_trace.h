@@ -0,0 +1,104 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Copyright (c) 2026 OpenSBI contributors.
+ */
+
+#ifndef __SBI_TRACE_H__
+#define __SBI_TRACE_H__
+
+#include <sbi/sbi_error.h>
+#include <sbi/sbi_types.h>
+
+/* clang-format off */
+
+/** Maximum number of integer arguments of a trace event */
+#define SBI_TRACE_MAX_ARGS		4
+
+/** Magic value of the trace export header ("SBTR") */
+#define SBI_TRACE_MAGIC			0x52544253
+
+/* clang-format on */
+
+/** Binary trace record */
+struct sbi_trace_entry {
+	/** Timer value when the event was recorded */
+	u64 time;
+	/** Offset of the format string from the firmware start */
+	u32 fmt;
+	/** Number of valid arguments */
+	u32 nargs;
+	/** Event arguments */
+	u64 args[SBI_TRACE_MAX_ARGS];
+};
+
+/** Header of the per-HART trace export */
+struct sbi_trace_header {
+	/** Always SBI_TRACE_MAGIC */
+	u32 magic;
+	/** HART which recorded the events */
+	u32 hartid;
+	/** Number of records following the header (oldest first) */
+	u32 count;
+	/** Number of records overwritten or truncated */
+	u32 lost;
+};
+
+struct sbi_scratch;
+
+#ifdef CONFIG_SBI_TRACE
+
+/** Per-HART heap space needed by the trace ring */
+#define SBI_TRACE_RING_SIZE						\
+	(sizeof(u32) * 2 +						\
+	 sizeof(struct sbi_trace_entry) * CONFIG_SBI_TRACE_ENTRIES)
+
+void __sbi_trace_record(const char *fmt, u32 nargs,
+			const unsigned long *args);
+
+/**
+ * Record a trace event in the ring of the current HART
+ *
+ * The format string is only referenced, never parsed, by the firmware.
+ * It lives in the .sbi_trace_fmt section and is expanded offline by
+ * scripts/sbi-trace-decode.py using the firmware ELF.
+ */
+#define sbi_trace(__fmt, ...)						\
+do {									\
+	static const char __sbi_trace_fmt[]				\
+		__attribute__((section(".sbi_trace_fmt"))) = __fmt;	\
+	const unsigned long __sbi_trace_args[] = { 0, ##__VA_ARGS__ };	\
+	_Static_assert(array_size(__sbi_trace_args) <=			\
+		       SBI_TRACE_MAX_ARGS + 1, "too many trace args");	\
+	__sbi_trace_record(__sbi_trace_fmt,				\
+			   array_size(__sbi_trace_args) - 1,		\
+			   &__sbi_trace_args[1]);			\
+} while (0)
+
+int sbi_trace_read(u32 hartid, void *buf, unsigned long size);
+
+void sbi_trace_dump(u32 hartid);
+
+int sbi_trace_init(struct sbi_scratch *scratch, bool cold_boot);
+
+#else
+
+#define SBI_TRACE_RING_SIZE		0
+
+#define sbi_trace(__fmt, ...)		do { } while (0)
+
+static inline int sbi_trace_read(u32 hartid, void *buf, unsigned long size)
+{
+	return SBI_ENOTSUPP;
+}
+
+static inline void sbi_trace_dump(u32 hartid) { }
+
+static inline int sbi_trace_init(struct sbi_scratch *scratch, bool cold_boot)
+{
+	return 0;
+}
+
+#endif
+
+#endif
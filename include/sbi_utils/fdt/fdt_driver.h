@@ -0,0 +1,63 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * fdt_driver.h - Flat Device Tree driver matching by compatible hash
+ *
+ * Copyright (c) 2026 OpenSBI contributors.
+ */
+
+#ifndef __FDT_DRIVER_H__
+#define __FDT_DRIVER_H__
+
+#include <sbi/sbi_types.h>
+#include <sbi_utils/fdt/fdt_helper.h>
+
+/* Maximum number of drivers matched against a single DT node */
+#define FDT_DRIVER_MAX_NODE_HITS	8
+
+struct fdt_driver_slot;
+
+/**
+ * Compatible string dispatch table of a driver carray
+ *
+ * Instances are generated by carray.sh for carrays which specify the
+ * match table member of their driver type. The hash of all compatible
+ * strings is built on first use.
+ */
+struct fdt_driver_table {
+	unsigned long count;
+	const struct fdt_match *(*match_table)(unsigned long pos);
+	struct fdt_driver_slot *slots;
+	unsigned long slot_mask;
+};
+
+/** A driver of a carray matching a DT node */
+struct fdt_driver_hit {
+	unsigned long pos;
+	int nodeoff;
+	const struct fdt_match *match;
+};
+
+/**
+ * Find the drivers matching a DT node
+ *
+ * Hits are returned in carray order and each driver is returned once
+ * with the first entry of its match table which the node satisfies.
+ *
+ * @return number of hits or negative error
+ */
+int fdt_driver_match_node(void *fdt, int nodeoff,
+			  struct fdt_driver_table *table,
+			  struct fdt_driver_hit *hits, int max_hits);
+
+/**
+ * Match all DT nodes against the drivers in a single walk
+ *
+ * Hits are sorted by carray position and then by node offset. The
+ * returned array must be released with sbi_free().
+ *
+ * @return number of hits or negative error
+ */
+int fdt_driver_scan(void *fdt, struct fdt_driver_table *table,
+		    struct fdt_driver_hit **out_hits);
+
+#endif
@@ -19,6 +19,87 @@ struct sbi_cpu_idle_state {
 	uint32_t wakeup_latency_us;
 };
 
+/** Maximum number of handlers of a single pass fixup */
+#define FDT_FIXUP_MAX_HANDLERS		16
+
+/** Maximum number of edits queued before they are applied */
+#define FDT_FIXUP_MAX_EDITS		32
+
+/** Maximum number of edits a handler may queue for one node */
+#define FDT_FIXUP_NODE_EDITS		8
+
+/** Edit of a node queued during a single pass fixup */
+struct fdt_fixup_edit {
+	/** Node to edit */
+	int nodeoff;
+	/** Property to delete or NULL to disable the node */
+	const char *prop;
+};
+
+/** State of a single pass fixup */
+struct fdt_fixup_pass {
+	/** Device tree blob being fixed up */
+	void *fdt;
+	/** Number of queued edits */
+	int count;
+	/** First error of queuing an edit */
+	int err;
+	/** Queued edits in the order of their nodes in the blob */
+	struct fdt_fixup_edit edits[FDT_FIXUP_MAX_EDITS];
+};
+
+/** Node handler of a single pass fixup */
+struct fdt_fixup_handler {
+	/** Handle nodes compatible with this string (NULL for any) */
+	const char *compatible;
+	/** Handle children of the node at this path (NULL for any) */
+	const char *parent_path;
+	/**
+	 * Fixup a matching node. Changes which do not resize the blob
+	 * may be done directly. Other changes must be queued for the
+	 * node with fdt_fixup_disable() or fdt_fixup_delprop().
+	 */
+	void (*fixup)(struct fdt_fixup_pass *pass, int nodeoff);
+};
+
+/**
+ * Queue setting the "status" property of a node to "disabled"
+ *
+ * @param pass: single pass fixup state
+ * @param nodeoff: node passed to the fixup handler
+ * @return zero on success and -ve on failure
+ */
+int fdt_fixup_disable(struct fdt_fixup_pass *pass, int nodeoff);
+
+/**
+ * Queue deleting a property of a node
+ *
+ * @param pass: single pass fixup state
+ * @param nodeoff: node passed to the fixup handler
+ * @param prop: name of the property, must stay valid until the pass ends
+ * @return zero on success and -ve on failure
+ */
+int fdt_fixup_delprop(struct fdt_fixup_pass *pass, int nodeoff,
+		      const char *prop);
+
+/**
+ * Run fixup handlers in a single walk of the device tree
+ *
+ * Each node is matched against all handlers once. Edits which resize the
+ * blob are queued so that node offsets seen by the handlers stay valid,
+ * and each batch is applied by rewriting the structure block in a single
+ * pass instead of moving the tail of the blob once per edit. An edit
+ * which could not be queued does not stop the walk but its error is
+ * returned once the other edits are applied.
+ *
+ * @param fdt: device tree blob
+ * @param handlers: array of fixup handlers
+ * @param count: number of fixup handlers
+ * @return zero on success and -ve on failure
+ */
+int fdt_fixup_run(void *fdt, const struct fdt_fixup_handler *handlers,
+		  int count);
+
 /**
  * Add CPU idle states to cpu nodes in the DT
  *
@@ -97,15 +178,16 @@ int fdt_reserved_memory_fixup(void *fdt);
  * General device tree fix-up
  *
  * This routine do all required device tree fix-ups for a typical platform.
- * It fixes up the PLIC node, IMSIC nodes, APLIC nodes, and the reserved
- * memory node in the device tree by calling the corresponding helper
- * routines to accomplish the task.
+ * It fixes up the CPU nodes, PLIC nodes, IMSIC nodes, APLIC nodes and the
+ * PMU node in a single walk of the device tree and then the reserved memory
+ * node.
  *
  * It is recommended that platform codes call this helper in their final_init()
  *
  * @param fdt: device tree blob
+ * @return zero on success and -ve on failure
  */
-void fdt_fixups(void *fdt);
+int fdt_fixups(void *fdt);
 
 #endif /* __FDT_FIXUP_H__ */
 
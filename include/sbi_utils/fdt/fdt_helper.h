@@ -32,6 +32,7 @@ struct platform_uart_data {
 	unsigned long reg_shift;
 	unsigned long reg_io_width;
 	unsigned long reg_offset;
+	unsigned long fifo_size;
 };
 
 const struct fdt_match *fdt_match_node(void *fdt, int nodeoff,
@@ -59,6 +60,8 @@ int fdt_parse_max_enabled_hart_id(void *fdt, u32 *max_hartid);
 
 int fdt_parse_timebase_frequency(void *fdt, unsigned long *freq);
 
+int fdt_parse_idle_states(void *fdt);
+
 int fdt_parse_isa_extensions(void *fdt, unsigned int hard_id,
 			     unsigned long *extensions);
 
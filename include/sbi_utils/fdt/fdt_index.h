@@ -0,0 +1,65 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * fdt_index.h - Flat Device Tree phandle, compatible and path index
+ *
+ * Copyright (c) 2026 OpenSBI contributors.
+ */
+
+#ifndef __FDT_INDEX_H__
+#define __FDT_INDEX_H__
+
+#include <libfdt.h>
+#include <sbi/sbi_types.h>
+
+#ifdef CONFIG_FDT_INDEX
+
+/**
+ * Build the phandle and compatible index of a device tree
+ *
+ * The index holds node offsets which are relative to the structure
+ * block so it stays valid when the blob is copied or expanded, but
+ * must be invalidated by anything which adds or removes nodes or
+ * properties. If the tree does not fit in the index then lookups
+ * fall back to libfdt.
+ *
+ * @param fdt device tree blob
+ */
+void fdt_index_build(const void *fdt);
+
+/** Drop the index after the device tree has been modified */
+void fdt_index_invalidate(void);
+
+int fdt_index_node_offset_by_phandle(const void *fdt, uint32_t phandle);
+
+int fdt_index_node_offset_by_compatible(const void *fdt, int startoffset,
+					const char *compatible);
+
+int fdt_index_path_offset(const void *fdt, const char *path);
+
+#else
+
+static inline void fdt_index_build(const void *fdt) { }
+
+static inline void fdt_index_invalidate(void) { }
+
+static inline int fdt_index_node_offset_by_phandle(const void *fdt,
+						   uint32_t phandle)
+{
+	return fdt_node_offset_by_phandle(fdt, phandle);
+}
+
+static inline int fdt_index_node_offset_by_compatible(const void *fdt,
+						      int startoffset,
+						      const char *compatible)
+{
+	return fdt_node_offset_by_compatible(fdt, startoffset, compatible);
+}
+
+static inline int fdt_index_path_offset(const void *fdt, const char *path)
+{
+	return fdt_path_offset(fdt, path);
+}
+
+#endif
+
+#endif
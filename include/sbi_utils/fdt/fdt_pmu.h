@@ -45,6 +45,16 @@ struct fdt_pmu_raw_event_counter_map {
  */
 int fdt_pmu_fixup(void *fdt);
 
+struct fdt_fixup_pass;
+
+/**
+ * Queue the PMU fixups of a node during a single pass fixup
+ *
+ * @param pass single pass fixup state
+ * @param pmu_offset offset of the PMU node
+ */
+void fdt_pmu_fixup_node(struct fdt_fixup_pass *pass, int pmu_offset);
+
 /**
  * Setup PMU data from device tree
  *
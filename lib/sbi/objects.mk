@@ -55,10 +55,18 @@ libsbi-objs-$(CONFIG_SBI_ECALL_VENDOR) += sbi_ecall_vendor.o
 carray-sbi_ecall_exts-$(CONFIG_SBI_ECALL_DBTR) += ecall_dbtr
 libsbi-objs-$(CONFIG_SBI_ECALL_DBTR) += sbi_ecall_dbtr.o
 
+carray-sbi_ecall_exts-$(CONFIG_SBI_ECALL_OPENSBI) += ecall_opensbi
+libsbi-objs-$(CONFIG_SBI_ECALL_OPENSBI) += sbi_ecall_opensbi.o
+
 libsbi-objs-y += sbi_bitmap.o
 libsbi-objs-y += sbi_bitops.o
 libsbi-objs-y += sbi_console.o
 libsbi-objs-y += sbi_domain.o
+libsbi-objs-$(CONFIG_SBI_DOMAIN_CONTEXT) += sbi_domain_context.o
+libsbi-objs-$(CONFIG_SBI_IDLE_GOVERNOR) += sbi_idle.o
+libsbi-objs-$(CONFIG_SBI_HSM_STATS) += sbi_hsm_stats.o
+libsbi-objs-$(CONFIG_SBI_BOOT_PROFILE) += sbi_boot_prof.o
+libsbi-objs-$(CONFIG_SBI_FW_TIMER) += sbi_fw_timer.o
 libsbi-objs-y += sbi_emulate_csr.o
 libsbi-objs-y += sbi_fifo.o
 libsbi-objs-y += sbi_hart.o
@@ -78,6 +86,7 @@ libsbi-objs-y += sbi_scratch.o
 libsbi-objs-y += sbi_string.o
 libsbi-objs-y += sbi_system.o
 libsbi-objs-y += sbi_timer.o
+libsbi-objs-$(CONFIG_SBI_TRACE) += sbi_trace.o
 libsbi-objs-y += sbi_tlb.o
 libsbi-objs-y += sbi_trap.o
 libsbi-objs-y += sbi_unpriv.o
@@ -300,35 +300,19 @@ int is_pmp_entry_mapped(unsigned long entry)
 	return false;
 }
 
-int pmp_set(unsigned int n, unsigned long prot, unsigned long addr,
-	    unsigned long log2len)
+int pmp_encode(unsigned long prot, unsigned long addr, unsigned long log2len,
+	       unsigned long *cfg_out, unsigned long *pmpaddr_out)
 {
-	int pmpcfg_csr, pmpcfg_shift, pmpaddr_csr;
-	unsigned long cfgmask, pmpcfg;
 	unsigned long addrmask, pmpaddr;
 
 	/* check parameters */
-	if (n >= PMP_COUNT || log2len > __riscv_xlen || log2len < PMP_SHIFT)
+	if (log2len > __riscv_xlen || log2len < PMP_SHIFT ||
+	    !cfg_out || !pmpaddr_out)
 		return SBI_EINVAL;
 
-	/* calculate PMP register and offset */
-#if __riscv_xlen == 32
-	pmpcfg_csr   = CSR_PMPCFG0 + (n >> 2);
-	pmpcfg_shift = (n & 3) << 3;
-#elif __riscv_xlen == 64
-	pmpcfg_csr   = (CSR_PMPCFG0 + (n >> 2)) & ~1;
-	pmpcfg_shift = (n & 7) << 3;
-#else
-# error "Unexpected __riscv_xlen"
-#endif
-	pmpaddr_csr = CSR_PMPADDR0 + n;
-
 	/* encode PMP config */
 	prot &= ~PMP_A;
 	prot |= (log2len == PMP_SHIFT) ? PMP_A_NA4 : PMP_A_NAPOT;
-	cfgmask = ~(0xffUL << pmpcfg_shift);
-	pmpcfg	= (csr_read_num(pmpcfg_csr) & cfgmask);
-	pmpcfg |= ((prot << pmpcfg_shift) & ~cfgmask);
 
 	/* encode PMP address */
 	if (log2len == PMP_SHIFT) {
@@ -343,6 +327,37 @@ int pmp_set(unsigned int n, unsigned long prot, unsigned long addr,
 		}
 	}
 
+	*cfg_out = prot & 0xffUL;
+	*pmpaddr_out = pmpaddr;
+
+	return 0;
+}
+
+int pmp_set_raw(unsigned int n, unsigned long cfg, unsigned long pmpaddr)
+{
+	int pmpcfg_csr, pmpcfg_shift, pmpaddr_csr;
+	unsigned long cfgmask, pmpcfg;
+
+	/* check parameters */
+	if (n >= PMP_COUNT)
+		return SBI_EINVAL;
+
+	/* calculate PMP register and offset */
+#if __riscv_xlen == 32
+	pmpcfg_csr   = CSR_PMPCFG0 + (n >> 2);
+	pmpcfg_shift = (n & 3) << 3;
+#elif __riscv_xlen == 64
+	pmpcfg_csr   = (CSR_PMPCFG0 + (n >> 2)) & ~1;
+	pmpcfg_shift = (n & 7) << 3;
+#else
+# error "Unexpected __riscv_xlen"
+#endif
+	pmpaddr_csr = CSR_PMPADDR0 + n;
+
+	cfgmask = ~(0xffUL << pmpcfg_shift);
+	pmpcfg	= (csr_read_num(pmpcfg_csr) & cfgmask);
+	pmpcfg |= ((cfg << pmpcfg_shift) & ~cfgmask);
+
 	/* write csrs */
 	csr_write_num(pmpaddr_csr, pmpaddr);
 	csr_write_num(pmpcfg_csr, pmpcfg);
@@ -350,6 +365,110 @@ int pmp_set(unsigned int n, unsigned long prot, unsigned long addr,
 	return 0;
 }
 
+int pmp_set(unsigned int n, unsigned long prot, unsigned long addr,
+	    unsigned long log2len)
+{
+	int rc;
+	unsigned long cfg, pmpaddr;
+
+	/* check parameters */
+	if (n >= PMP_COUNT)
+		return SBI_EINVAL;
+
+	rc = pmp_encode(prot, addr, log2len, &cfg, &pmpaddr);
+	if (rc)
+		return rc;
+
+	return pmp_set_raw(n, cfg, pmpaddr);
+}
+
+void pmpaddr_write_all(const unsigned long *pmpaddr, unsigned int count)
+{
+#define case_pmpaddr_write(__n)					\
+	case (__n) + 1:						\
+		csr_write(CSR_PMPADDR0 + (__n), pmpaddr[__n]);
+#define case_pmpaddr_write_2(__n)				\
+	case_pmpaddr_write((__n) + 1)				\
+	case_pmpaddr_write((__n) + 0)
+#define case_pmpaddr_write_4(__n)				\
+	case_pmpaddr_write_2((__n) + 2)				\
+	case_pmpaddr_write_2((__n) + 0)
+#define case_pmpaddr_write_8(__n)				\
+	case_pmpaddr_write_4((__n) + 4)				\
+	case_pmpaddr_write_4((__n) + 0)
+#define case_pmpaddr_write_16(__n)				\
+	case_pmpaddr_write_8((__n) + 8)				\
+	case_pmpaddr_write_8((__n) + 0)
+#define case_pmpaddr_write_32(__n)				\
+	case_pmpaddr_write_16((__n) + 16)			\
+	case_pmpaddr_write_16((__n) + 0)
+#define case_pmpaddr_write_64(__n)				\
+	case_pmpaddr_write_32((__n) + 32)			\
+	case_pmpaddr_write_32((__n) + 0)
+
+	/* Jump into a straight-line sequence of CSR writes */
+	switch (MIN(count, (unsigned int)PMP_COUNT)) {
+	case_pmpaddr_write_64(0)
+	default:
+		break;
+	}
+
+#undef case_pmpaddr_write_64
+#undef case_pmpaddr_write_32
+#undef case_pmpaddr_write_16
+#undef case_pmpaddr_write_8
+#undef case_pmpaddr_write_4
+#undef case_pmpaddr_write_2
+#undef case_pmpaddr_write
+}
+
+void pmpcfg_write_all(const unsigned long *pmpcfg, unsigned int count)
+{
+#if __riscv_xlen == 32
+#define pmpcfg_csr(__n)		(CSR_PMPCFG0 + (__n))
+#elif __riscv_xlen == 64
+#define pmpcfg_csr(__n)		(CSR_PMPCFG0 + ((__n) * 2))
+#else
+# error "Unexpected __riscv_xlen"
+#endif
+#define case_pmpcfg_write(__n)					\
+	case (__n) + 1:						\
+		csr_write(pmpcfg_csr(__n), pmpcfg[__n]);
+#define case_pmpcfg_write_2(__n)				\
+	case_pmpcfg_write((__n) + 1)				\
+	case_pmpcfg_write((__n) + 0)
+#define case_pmpcfg_write_4(__n)				\
+	case_pmpcfg_write_2((__n) + 2)				\
+	case_pmpcfg_write_2((__n) + 0)
+#define case_pmpcfg_write_8(__n)				\
+	case_pmpcfg_write_4((__n) + 4)				\
+	case_pmpcfg_write_4((__n) + 0)
+#define case_pmpcfg_write_16(__n)				\
+	case_pmpcfg_write_8((__n) + 8)				\
+	case_pmpcfg_write_8((__n) + 0)
+
+	count = (MIN(count, (unsigned int)PMP_COUNT) + PMP_CFG_PER_REG - 1) /
+		PMP_CFG_PER_REG;
+
+	/* Jump into a straight-line sequence of CSR writes */
+	switch (count) {
+#if __riscv_xlen == 32
+	case_pmpcfg_write_16(0)
+#else
+	case_pmpcfg_write_8(0)
+#endif
+	default:
+		break;
+	}
+
+#undef case_pmpcfg_write_16
+#undef case_pmpcfg_write_8
+#undef case_pmpcfg_write_4
+#undef case_pmpcfg_write_2
+#undef case_pmpcfg_write
+#undef pmpcfg_csr
+}
+
 int pmp_get(unsigned int n, unsigned long *prot_out, unsigned long *addr_out,
 	    unsigned long *log2len)
 {
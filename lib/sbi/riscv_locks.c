@@ -7,6 +7,7 @@
 
 #include <sbi/riscv_barrier.h>
 #include <sbi/riscv_locks.h>
+#include <sbi/sbi_hart.h>
 
 static inline bool spin_lock_unlocked(spinlock_t lock)
 {
@@ -48,27 +49,29 @@ bool spin_trylock(spinlock_t *lock)
 void spin_lock(spinlock_t *lock)
 {
 	unsigned long inc = 1u << TICKET_SHIFT;
-	unsigned long mask = 0xffffu;
-	u32 l0, tmp1, tmp2;
+	volatile u32 *word = (volatile u32 *)lock;
+	u32 l0, ticket;
+	bool wrs;
 
-	__asm__ __volatile__(
-		/* Atomically increment the next ticket. */
-		"	amoadd.w.aqrl	%0, %4, %3\n"
+	/* Atomically increment the next ticket. */
+	__asm__ __volatile__("	amoadd.w.aqrl	%0, %2, %1\n"
+			     : "=&r"(l0), "+A"(*lock)
+			     : "r"(inc)
+			     : "memory");
 
-		/* Did we get the lock? */
-		"	srli	%1, %0, %6\n"
-		"	and	%1, %1, %5\n"
-		"1:	and	%2, %0, %5\n"
-		"	beq	%1, %2, 2f\n"
+	/* If we did not get the lock, then wait for our turn. */
+	ticket = (l0 >> TICKET_SHIFT) & 0xffffu;
+	if ((l0 & 0xffffu) == ticket)
+		return;
 
-		/* If not, then spin on the lock. */
-		"	lw	%0, %3\n"
-		RISCV_ACQUIRE_BARRIER
-		"	j	1b\n"
-		"2:"
-		: "=&r"(l0), "=&r"(tmp1), "=&r"(tmp2), "+A"(*lock)
-		: "r"(inc), "r"(mask), "I"(TICKET_SHIFT)
-		: "memory");
+	/* The lock word now also holds our own ticket increment */
+	l0 += inc;
+	wrs = sbi_hart_can_wait_on_addr();
+	while ((l0 & 0xffffu) != ticket) {
+		if (wrs)
+			__sbi_hart_wait_on_u32(word, l0, false);
+		l0 = __smp_load_acquire(word);
+	}
 }
 
 void spin_unlock(spinlock_t *lock)
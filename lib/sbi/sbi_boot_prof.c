@@ -0,0 +1,132 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Copyright (c) 2026 OpenSBI contributors.
+ */
+
+#include <sbi/riscv_asm.h>
+#include <sbi/sbi_boot_prof.h>
+#include <sbi/sbi_console.h>
+#include <sbi/sbi_error.h>
+#include <sbi/sbi_scratch.h>
+
+/*
+ * 64-bit MCYCLE values recorded by fw_base.S before BSS is cleared.
+ * Firmwares which do not provide them only get the phases recorded
+ * by libsbi.
+ */
+extern u64 fw_boot_stamps[SBI_BOOT_PHASE_FW_COUNT] __attribute__((weak));
+
+static u64 boot_stamps[SBI_BOOT_PHASE_MAX];
+
+static u64 boot_prof_cycles(void)
+{
+#if __riscv_xlen == 32
+	u32 lo, hi, tmp;
+
+	do {
+		hi = csr_read(CSR_MCYCLEH);
+		lo = csr_read(CSR_MCYCLE);
+		tmp = csr_read(CSR_MCYCLEH);
+	} while (hi != tmp);
+
+	return ((u64)hi << 32) | lo;
+#else
+	return csr_read(CSR_MCYCLE);
+#endif
+}
+
+static const char *const boot_phase_names[SBI_BOOT_PHASE_MAX] = {
+	[SBI_BOOT_PHASE_FW_ENTRY]		= "Firmware Entry",
+	[SBI_BOOT_PHASE_RELOCATE]		= "Relocation",
+	[SBI_BOOT_PHASE_BSS_ZERO]		= "BSS Zero",
+	[SBI_BOOT_PHASE_FW_SCRATCH]		= "Platform/Scratch Setup",
+	[SBI_BOOT_PHASE_FDT_RELOCATE]		= "FDT Relocation",
+	[SBI_BOOT_PHASE_SBI_ENTRY]		= "SBI Entry",
+	[SBI_BOOT_PHASE_SCRATCH]		= "Scratch",
+	[SBI_BOOT_PHASE_HEAP]			= "Heap",
+	[SBI_BOOT_PHASE_DOMAIN]			= "Domain",
+	[SBI_BOOT_PHASE_TRACE]			= "Trace",
+	[SBI_BOOT_PHASE_HSM]			= "HSM",
+	[SBI_BOOT_PHASE_PLATFORM_EARLY]		= "Platform Early",
+	[SBI_BOOT_PHASE_HART]			= "HART",
+	[SBI_BOOT_PHASE_CONSOLE]		= "Console",
+	[SBI_BOOT_PHASE_PMU]			= "PMU",
+	[SBI_BOOT_PHASE_DBTR]			= "Debug Triggers",
+	[SBI_BOOT_PHASE_BANNER]			= "Banner",
+	[SBI_BOOT_PHASE_IRQCHIP]		= "IRQ Chip",
+	[SBI_BOOT_PHASE_CONSOLE_IRQ]		= "Console IRQ",
+	[SBI_BOOT_PHASE_IPI]			= "IPI",
+	[SBI_BOOT_PHASE_TLB]			= "TLB",
+	[SBI_BOOT_PHASE_TIMER]			= "Timer",
+	[SBI_BOOT_PHASE_DOMAIN_FINALIZE]	= "Domain Finalize",
+	[SBI_BOOT_PHASE_PLATFORM_FINAL]		= "Platform Final",
+	[SBI_BOOT_PHASE_ECALL]			= "Ecall",
+	[SBI_BOOT_PHASE_BOOT_PRINTS]		= "Boot Prints",
+	[SBI_BOOT_PHASE_PMP]			= "PMP",
+};
+
+void sbi_boot_prof_mark(enum sbi_boot_phase phase)
+{
+	if (phase < SBI_BOOT_PHASE_MAX)
+		boot_stamps[phase] = boot_prof_cycles();
+}
+
+static void boot_prof_collect(void)
+{
+	u32 i;
+
+	if (!fw_boot_stamps || boot_stamps[SBI_BOOT_PHASE_FW_ENTRY])
+		return;
+
+	for (i = 0; i < SBI_BOOT_PHASE_FW_COUNT; i++)
+		boot_stamps[i] = fw_boot_stamps[i];
+}
+
+void sbi_boot_prof_print(struct sbi_scratch *scratch)
+{
+	u64 first = 0, prev = 0;
+	u32 i;
+
+	if (scratch->options & SBI_SCRATCH_NO_BOOT_PRINTS)
+		return;
+
+	boot_prof_collect();
+
+	for (i = 0; i < SBI_BOOT_PHASE_MAX; i++) {
+		if (!boot_stamps[i])
+			continue;
+		if (!first) {
+			first = prev = boot_stamps[i];
+			continue;
+		}
+		sbi_printf("Boot Phase %-22s: %llu cycles\n",
+			   boot_phase_names[i],
+			   (unsigned long long)(boot_stamps[i] - prev));
+		prev = boot_stamps[i];
+	}
+	sbi_printf("Boot Phase %-22s: %llu cycles\n", "Total",
+		   (unsigned long long)(prev - first));
+}
+
+int sbi_boot_prof_read(void *buf, unsigned long size)
+{
+	struct sbi_boot_prof_header *hdr = buf;
+	u64 *out = (void *)(hdr + 1);
+	u32 i;
+
+	if (size < sizeof(*hdr) + sizeof(*out) * SBI_BOOT_PHASE_MAX)
+		return SBI_EINVAL;
+	/* Stamps are stored directly so the buffer must be aligned */
+	if ((unsigned long)buf & (__alignof__(*out) - 1))
+		return SBI_EINVAL;
+
+	boot_prof_collect();
+
+	hdr->magic = SBI_BOOT_PROF_MAGIC;
+	hdr->count = SBI_BOOT_PHASE_MAX;
+	for (i = 0; i < SBI_BOOT_PHASE_MAX; i++)
+		out[i] = boot_stamps[i];
+
+	return sizeof(*hdr) + sizeof(*out) * SBI_BOOT_PHASE_MAX;
+}
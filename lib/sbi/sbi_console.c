@@ -9,10 +9,15 @@
 
 #include <sbi/riscv_locks.h>
 #include <sbi/sbi_console.h>
+#include <sbi/sbi_error.h>
+#include <sbi/sbi_fw_timer.h>
 #include <sbi/sbi_hart.h>
+#include <sbi/sbi_irqchip.h>
 #include <sbi/sbi_platform.h>
+#include <sbi/sbi_pmu.h>
 #include <sbi/sbi_scratch.h>
 #include <sbi/sbi_string.h>
+#include <sbi/sbi_timer.h>
 
 #define CONSOLE_TBUF_MAX 256
 
@@ -21,6 +26,162 @@ static char console_tbuf[CONSOLE_TBUF_MAX];
 static u32 console_tbuf_len;
 static spinlock_t console_out_lock	       = SPIN_LOCK_INITIALIZER;
 
+#ifdef CONFIG_SBI_CONSOLE_IRQ
+
+#define CONSOLE_TX_RING_SIZE	4096
+#define CONSOLE_RX_RING_SIZE	256
+
+/* Period of the output drain backing up the TX ready interrupt */
+#define CONSOLE_TX_POLL_US	10000
+
+/* Output ring, protected by console_out_lock */
+static char console_tx_ring[CONSOLE_TX_RING_SIZE];
+static u32 console_tx_head, console_tx_tail;
+static bool console_tx_irq;
+
+/* Input ring, protected by console_in_lock */
+static u8 console_rx_ring[CONSOLE_RX_RING_SIZE];
+static u32 console_rx_head, console_rx_tail;
+static spinlock_t console_in_lock = SPIN_LOCK_INITIALIZER;
+
+static u32 console_irq;
+static u32 console_irq_hartid;
+static bool console_irq_active;
+
+static void console_tx_timer_fn(struct sbi_fw_timer *timer);
+
+static struct sbi_fw_timer console_tx_timer = {
+	.fn = console_tx_timer_fn,
+};
+
+/*
+ * Drain the output ring again later in case the TX ready interrupt is
+ * lost. The timer is only armed on the HART taking the console irq and
+ * its large slack lets it share the interrupt of other timer events.
+ */
+static void console_tx_timer_arm(void)
+{
+	const struct sbi_timer_device *tdev = sbi_timer_get_device();
+	u64 ticks;
+
+	if (console_irq_hartid != current_hartid() ||
+	    !tdev || !tdev->timer_freq ||
+	    sbi_fw_timer_pending(&console_tx_timer))
+		return;
+
+	ticks = ((u64)tdev->timer_freq * CONSOLE_TX_POLL_US) / 1000000;
+	/* Without firmware timers the TX ready interrupt is all we have */
+	sbi_fw_timer_add(&console_tx_timer, sbi_timer_value() + ticks, ticks);
+}
+
+/* Must be called with console_out_lock held */
+static void console_tx_drain(void)
+{
+	u32 pos;
+	unsigned long len, count;
+	bool tx_irq;
+
+	while (console_tx_head != console_tx_tail) {
+		pos = console_tx_tail & (CONSOLE_TX_RING_SIZE - 1);
+		len = console_tx_head - console_tx_tail;
+		if (len > CONSOLE_TX_RING_SIZE - pos)
+			len = CONSOLE_TX_RING_SIZE - pos;
+
+		count = console_dev->console_tx_fill(&console_tx_ring[pos], len);
+		if (!count)
+			break;
+		console_tx_tail += count;
+	}
+
+	/* Let the TX ready interrupt push out whatever is left */
+	tx_irq = console_tx_head != console_tx_tail;
+	if (tx_irq != console_tx_irq) {
+		console_dev->console_irq_enable(tx_irq, true);
+		console_tx_irq = tx_irq;
+	}
+	if (tx_irq)
+		console_tx_timer_arm();
+}
+
+static void console_tx_timer_fn(struct sbi_fw_timer *timer)
+{
+	spin_lock(&console_out_lock);
+	if (console_irq_active)
+		console_tx_drain();
+	spin_unlock(&console_out_lock);
+}
+
+/* Must be called with console_out_lock held */
+static void console_tx_flush(void)
+{
+	while (console_tx_head != console_tx_tail)
+		console_tx_drain();
+}
+
+/* Must be called with console_out_lock held */
+static unsigned long console_tx_queue(const char *str, unsigned long len)
+{
+	u32 need;
+	unsigned long i;
+
+	for (i = 0; i < len; i++) {
+		need = (str[i] == '\n') ? 2 : 1;
+
+		/* Ring is full so push out synchronously */
+		while (CONSOLE_TX_RING_SIZE -
+		       (console_tx_head - console_tx_tail) < need)
+			console_tx_drain();
+
+		if (str[i] == '\n')
+			console_tx_ring[console_tx_head++ &
+					(CONSOLE_TX_RING_SIZE - 1)] = '\r';
+		console_tx_ring[console_tx_head++ &
+				(CONSOLE_TX_RING_SIZE - 1)] = str[i];
+	}
+
+	console_tx_drain();
+
+	return len;
+}
+
+static int console_rx_getc(void)
+{
+	int ch = -1;
+
+	spin_lock(&console_in_lock);
+	if (console_rx_head != console_rx_tail)
+		ch = console_rx_ring[console_rx_tail++ &
+				     (CONSOLE_RX_RING_SIZE - 1)];
+	else if (console_dev && console_dev->console_getc)
+		ch = console_dev->console_getc();
+	spin_unlock(&console_in_lock);
+
+	return ch;
+}
+
+static int console_irq_handler(u32 hwirq, void *priv)
+{
+	int ch;
+
+	/* Drain the device even when the ring is full to ack the irq */
+	spin_lock(&console_in_lock);
+	while ((ch = console_dev->console_getc()) >= 0) {
+		if (console_rx_head - console_rx_tail < CONSOLE_RX_RING_SIZE)
+			console_rx_ring[console_rx_head++ &
+					(CONSOLE_RX_RING_SIZE - 1)] = ch;
+	}
+	spin_unlock(&console_in_lock);
+
+	spin_lock(&console_out_lock);
+	if (console_irq_active)
+		console_tx_drain();
+	spin_unlock(&console_out_lock);
+
+	return 0;
+}
+
+#endif
+
 bool sbi_isprintable(char c)
 {
 	if (((31 < c) && (c < 127)) || (c == '\f') || (c == '\r') ||
@@ -32,15 +193,29 @@ bool sbi_isprintable(char c)
 
 int sbi_getc(void)
 {
+	unsigned long res_start = sbi_pmu_residency_start();
+	int ch = -1;
+
+#ifdef CONFIG_SBI_CONSOLE_IRQ
+	ch = console_rx_getc();
+#else
 	if (console_dev && console_dev->console_getc)
-		return console_dev->console_getc();
-	return -1;
+		ch = console_dev->console_getc();
+#endif
+
+	sbi_pmu_residency_end(SBI_PMU_FW_RES_CONSOLE, res_start);
+	return ch;
 }
 
 static unsigned long nputs(const char *str, unsigned long len)
 {
 	unsigned long i;
 
+#ifdef CONFIG_SBI_CONSOLE_IRQ
+	if (console_irq_active)
+		return console_tx_queue(str, len);
+#endif
+
 	if (console_dev) {
 		if (console_dev->console_puts)
 			return console_dev->console_puts(str, len);
@@ -65,7 +240,13 @@ static void nputs_all(const char *str, unsigned long len)
 
 void sbi_putc(char ch)
 {
+	unsigned long res_start = sbi_pmu_residency_start();
+
+	spin_lock(&console_out_lock);
 	nputs_all(&ch, 1);
+	spin_unlock(&console_out_lock);
+
+	sbi_pmu_residency_end(SBI_PMU_FW_RES_CONSOLE, res_start);
 }
 
 void sbi_puts(const char *str)
@@ -79,12 +260,13 @@ void sbi_puts(const char *str)
 
 unsigned long sbi_nputs(const char *str, unsigned long len)
 {
-	unsigned long ret;
+	unsigned long ret, res_start = sbi_pmu_residency_start();
 
 	spin_lock(&console_out_lock);
 	ret = nputs(str, len);
 	spin_unlock(&console_out_lock);
 
+	sbi_pmu_residency_end(SBI_PMU_FW_RES_CONSOLE, res_start);
 	return ret;
 }
 
@@ -131,7 +313,7 @@ typedef __builtin_va_list va_list;
 static void printc(char **out, u32 *out_len, char ch, int flags)
 {
 	if (!out) {
-		sbi_putc(ch);
+		nputs_all(&ch, 1);
 		return;
 	}
 
@@ -460,6 +642,10 @@ void sbi_panic(const char *format, ...)
 	va_start(args, format);
 	print(NULL, NULL, format, args);
 	va_end(args);
+#ifdef CONFIG_SBI_CONSOLE_IRQ
+	if (console_irq_active)
+		console_tx_flush();
+#endif
 	spin_unlock(&console_out_lock);
 
 	sbi_hart_hang();
@@ -488,3 +674,55 @@ int sbi_console_init(struct sbi_scratch *scratch)
 
 	return rc;
 }
+
+#ifdef CONFIG_SBI_CONSOLE_IRQ
+
+void sbi_console_set_irq(u32 hwirq)
+{
+	console_irq = hwirq;
+}
+
+int sbi_console_irq_init(struct sbi_scratch *scratch)
+{
+	int rc;
+
+	if (!console_irq || !console_dev || !console_dev->console_tx_fill ||
+	    !console_dev->console_irq_enable)
+		return 0;
+
+	rc = sbi_irqchip_register_handler(console_irq,
+					  console_irq_handler, NULL);
+	/* Stay in polled mode if the irqchip cannot route the source */
+	if (rc == SBI_ENODEV)
+		return 0;
+	if (rc)
+		return rc;
+
+	spin_lock(&console_out_lock);
+	console_irq_hartid = current_hartid();
+	console_tx_irq = false;
+	console_dev->console_irq_enable(false, true);
+	console_irq_active = true;
+	spin_unlock(&console_out_lock);
+
+	return 0;
+}
+
+void sbi_console_exit(struct sbi_scratch *scratch)
+{
+	if (!console_irq_active || console_irq_hartid != current_hartid())
+		return;
+
+	/* Fall back to polled mode since nobody will take the irq */
+	spin_lock(&console_out_lock);
+	console_tx_flush();
+	console_dev->console_irq_enable(false, false);
+	console_irq_active = false;
+	spin_unlock(&console_out_lock);
+
+	sbi_fw_timer_cancel(&console_tx_timer);
+
+	sbi_irqchip_unregister_handler(console_irq);
+}
+
+#endif
@@ -10,6 +10,7 @@
 #include <sbi/riscv_asm.h>
 #include <sbi/sbi_console.h>
 #include <sbi/sbi_domain.h>
+#include <sbi/sbi_hart.h>
 #include <sbi/sbi_hartmask.h>
 #include <sbi/sbi_heap.h>
 #include <sbi/sbi_hsm.h>
@@ -111,16 +112,18 @@ void sbi_domain_memregion_init(unsigned long addr,
 	}
 }
 
-bool sbi_domain_check_addr(const struct sbi_domain *dom,
-			   unsigned long addr, unsigned long mode,
-			   unsigned long access_flags)
+static inline unsigned long region_end(const struct sbi_domain_memregion *reg)
 {
-	bool rmmio, mmio = false;
-	struct sbi_domain_memregion *reg;
-	unsigned long rstart, rend, rflags, rwx = 0, rrwx = 0;
+	return (reg->order < __riscv_xlen) ?
+		reg->base + ((1UL << reg->order) - 1) : -1UL;
+}
 
-	if (!dom)
-		return false;
+static bool is_region_access_allowed(const struct sbi_domain_memregion *reg,
+				     unsigned long mode,
+				     unsigned long access_flags)
+{
+	bool rmmio, mmio = false;
+	unsigned long rflags = reg->flags, rwx = 0, rrwx;
 
 	/*
 	 * Use M_{R/W/X} bits because the SU-bits are at the
@@ -139,24 +142,59 @@ bool sbi_domain_check_addr(const struct sbi_domain *dom,
 	if (access_flags & SBI_DOMAIN_MMIO)
 		mmio = true;
 
-	sbi_domain_for_each_memregion(dom, reg) {
-		rflags = reg->flags;
-		rrwx = (mode == PRV_M ?
-			(rflags & SBI_DOMAIN_MEMREGION_M_ACCESS_MASK) :
-			(rflags & SBI_DOMAIN_MEMREGION_SU_ACCESS_MASK)
-			>> SBI_DOMAIN_MEMREGION_SU_ACCESS_SHIFT);
+	rrwx = (mode == PRV_M ?
+		(rflags & SBI_DOMAIN_MEMREGION_M_ACCESS_MASK) :
+		(rflags & SBI_DOMAIN_MEMREGION_SU_ACCESS_MASK)
+		>> SBI_DOMAIN_MEMREGION_SU_ACCESS_SHIFT);
 
-		rstart = reg->base;
-		rend = (reg->order < __riscv_xlen) ?
-			rstart + ((1UL << reg->order) - 1) : -1UL;
-		if (rstart <= addr && addr <= rend) {
-			rmmio = (rflags & SBI_DOMAIN_MEMREGION_MMIO) ? true : false;
-			if (mmio != rmmio)
-				return false;
-			return ((rrwx & rwx) == rwx) ? true : false;
-		}
+	rmmio = (rflags & SBI_DOMAIN_MEMREGION_MMIO) ? true : false;
+	if (mmio != rmmio)
+		return false;
+
+	return ((rrwx & rwx) == rwx) ? true : false;
+}
+
+/* Index of the span containing addr or of the first span after addr */
+static u32 find_span(const struct sbi_domain *dom, unsigned long addr)
+{
+	u32 lo = 0, hi = dom->span_count, mid;
+
+	while (lo < hi) {
+		mid = lo + (hi - lo) / 2;
+		if (dom->spans[mid].end < addr)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	return lo;
+}
+
+static const struct sbi_domain_memregion *find_region(
+						const struct sbi_domain *dom,
+						unsigned long addr);
+
+bool sbi_domain_check_addr(const struct sbi_domain *dom,
+			   unsigned long addr, unsigned long mode,
+			   unsigned long access_flags)
+{
+	const struct sbi_domain_memregion *reg;
+	u32 i;
+
+	if (!dom)
+		return false;
+
+	if (dom->spans) {
+		i = find_span(dom, addr);
+		reg = (i < dom->span_count && dom->spans[i].start <= addr) ?
+		      dom->spans[i].reg : NULL;
+	} else {
+		reg = find_region(dom, addr);
 	}
 
+	if (reg)
+		return is_region_access_allowed(reg, mode, access_flags);
+
 	return (mode == PRV_M) ? true : false;
 }
 
@@ -221,14 +259,11 @@ static const struct sbi_domain_memregion *find_region(
 						const struct sbi_domain *dom,
 						unsigned long addr)
 {
-	unsigned long rstart, rend;
 	struct sbi_domain_memregion *reg;
 
+	/* Regions are sorted so the first match is the most specific one */
 	sbi_domain_for_each_memregion(dom, reg) {
-		rstart = reg->base;
-		rend = (reg->order < __riscv_xlen) ?
-			rstart + ((1UL << reg->order) - 1) : -1UL;
-		if (rstart <= addr && addr <= rend)
+		if (reg->base <= addr && addr <= region_end(reg))
 			return reg;
 	}
 
@@ -394,10 +429,27 @@ bool sbi_domain_check_addr_range(const struct sbi_domain *dom,
 {
 	unsigned long max = addr + size;
 	const struct sbi_domain_memregion *reg, *sreg;
+	const struct sbi_domain_memspan *span;
+	u32 i;
 
 	if (!dom)
 		return false;
 
+	/* Validate the whole range in one pass over the spans */
+	if (dom->spans && size) {
+		for (i = find_span(dom, addr); i < dom->span_count; i++) {
+			span = &dom->spans[i];
+			if (addr < span->start ||
+			    !is_region_access_allowed(span->reg, mode,
+						      access_flags))
+				return false;
+			if (max - 1 <= span->end)
+				return true;
+			addr = span->end + 1;
+		}
+		return false;
+	}
+
 	while (addr < max) {
 		reg = find_region(dom, addr);
 		if (!reg)
@@ -501,6 +553,16 @@ void sbi_domain_dump(const struct sbi_domain *dom, const char *suffix)
 
 	sbi_printf("Domain%d SysSuspend  %s: %s\n",
 		   dom->index, suffix, (dom->system_suspend_allowed) ? "yes" : "no");
+
+#ifdef CONFIG_SBI_DOMAIN_CONTEXT
+	k = 0;
+	sbi_printf("Domain%d SwitchFrom  %s: ", dom->index, suffix);
+	for (i = 0; i < SBI_DOMAIN_MAX_INDEX; i++) {
+		if (__test_bit(i, dom->switch_from))
+			sbi_printf("%s%d", (k++) ? "," : "", i);
+	}
+	sbi_printf("%s\n", k ? "" : "none");
+#endif
 }
 
 void sbi_domain_dump_all(const char *suffix)
@@ -585,6 +647,56 @@ int sbi_domain_register(struct sbi_domain *dom,
 	return 0;
 }
 
+int sbi_domain_allow_switch(struct sbi_domain *dom,
+			    const struct sbi_domain *from)
+{
+	if (!dom || !from || domain_finalized)
+		return SBI_EINVAL;
+
+	__set_bit(from->index, dom->switch_from);
+
+	return 0;
+}
+
+bool sbi_domain_switch_allowed(const struct sbi_domain *dom,
+			       const struct sbi_domain *from, u32 hartindex)
+{
+	if (!dom || !from ||
+	    !sbi_hartmask_test_hartindex(hartindex, dom->possible_harts))
+		return false;
+
+	/* A HART can always return to the domain it is assigned to */
+	if (sbi_hartmask_test_hartindex(hartindex, &dom->assigned_harts))
+		return true;
+
+	return __test_bit(from->index, dom->switch_from);
+}
+
+int sbi_domain_switch_hart(u32 hartindex, struct sbi_domain *dom)
+{
+	if (!dom || !domain_finalized ||
+	    !sbi_hartmask_test_hartindex(hartindex, dom->possible_harts))
+		return SBI_EINVAL;
+
+	update_hartindex_to_domain(hartindex, dom);
+
+	return 0;
+}
+
+void sbi_domain_reset_hart(u32 hartindex)
+{
+	u32 i;
+	struct sbi_domain *dom;
+
+	sbi_domain_for_each(i, dom) {
+		if (sbi_hartmask_test_hartindex(hartindex,
+						&dom->assigned_harts)) {
+			update_hartindex_to_domain(hartindex, dom);
+			return;
+		}
+	}
+}
+
 int sbi_domain_root_add_memregion(const struct sbi_domain_memregion *reg)
 {
 	int rc;
@@ -672,6 +784,75 @@ int sbi_domain_root_add_memrange(unsigned long addr, unsigned long size,
 	return 0;
 }
 
+static int build_domain_spans(struct sbi_domain *dom)
+{
+	const struct sbi_domain_memregion *reg, *sreg;
+	struct sbi_domain_memspan *span;
+	unsigned long *points, tmp;
+	u32 i, j, count = 0, npoints = 0;
+
+	sbi_domain_for_each_memregion(dom, reg)
+		count++;
+	if (!count)
+		return 0;
+
+	/* Start addresses of all elementary spans */
+	points = sbi_calloc(sizeof(*points), 2 * count);
+	if (!points)
+		return SBI_ENOMEM;
+	sbi_domain_for_each_memregion(dom, reg) {
+		points[npoints++] = reg->base;
+		if (region_end(reg) != -1UL)
+			points[npoints++] = region_end(reg) + 1;
+	}
+
+	/* Sort and remove duplicates */
+	for (i = 1; i < npoints; i++) {
+		for (j = i; j > 0 && points[j - 1] > points[j]; j--) {
+			tmp = points[j];
+			points[j] = points[j - 1];
+			points[j - 1] = tmp;
+		}
+	}
+	for (i = 0, j = 0; i < npoints; i++) {
+		if (!j || points[j - 1] != points[i])
+			points[j++] = points[i];
+	}
+	npoints = j;
+
+	dom->spans = sbi_calloc(sizeof(*dom->spans), npoints);
+	if (!dom->spans) {
+		sbi_free(points);
+		return SBI_ENOMEM;
+	}
+
+	/*
+	 * Resolve each elementary span to its most specific region and
+	 * merge neighbouring spans which resolve to the same region.
+	 */
+	dom->span_count = 0;
+	for (i = 0; i < npoints; i++) {
+		sreg = find_region(dom, points[i]);
+		if (!sreg)
+			continue;
+
+		span = dom->span_count ? &dom->spans[dom->span_count - 1] : NULL;
+		if (span && span->reg == sreg && span->end + 1 == points[i]) {
+			span->end = (i + 1 < npoints) ? points[i + 1] - 1 : -1UL;
+			continue;
+		}
+
+		span = &dom->spans[dom->span_count++];
+		span->start = points[i];
+		span->end = (i + 1 < npoints) ? points[i + 1] - 1 : -1UL;
+		span->reg = sreg;
+	}
+
+	sbi_free(points);
+
+	return 0;
+}
+
 int sbi_domain_finalize(struct sbi_scratch *scratch, u32 cold_hartid)
 {
 	int rc;
@@ -687,6 +868,30 @@ int sbi_domain_finalize(struct sbi_scratch *scratch, u32 cold_hartid)
 		return rc;
 	}
 
+	/* Build address span index of domains */
+	sbi_domain_for_each(i, dom) {
+		rc = build_domain_spans(dom);
+		if (rc) {
+			sbi_printf("%s: %s span index failed (error %d)\n",
+				   __func__, dom->name, rc);
+			return rc;
+		}
+	}
+
+	/* Precompute PMP entries of domains */
+	sbi_domain_for_each(i, dom) {
+		dom->pmp_image = sbi_zalloc(sizeof(*dom->pmp_image));
+		if (!dom->pmp_image)
+			return SBI_ENOMEM;
+
+		rc = sbi_hart_pmp_image_build(scratch, dom, dom->pmp_image);
+		if (rc) {
+			sbi_printf("%s: %s PMP image failed (error %d)\n",
+				   __func__, dom->name, rc);
+			return rc;
+		}
+	}
+
 	/* Startup boot HART of domains */
 	sbi_domain_for_each(i, dom) {
 		/* Domain boot HART index */
@@ -0,0 +1,405 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Copyright (c) 2026 OpenSBI contributors.
+ */
+
+#include <sbi/riscv_asm.h>
+#include <sbi/riscv_encoding.h>
+#include <sbi/sbi_bitops.h>
+#include <sbi/sbi_domain.h>
+#include <sbi/sbi_domain_context.h>
+#include <sbi/sbi_hart.h>
+#include <sbi/sbi_hartmask.h>
+#include <sbi/sbi_heap.h>
+#include <sbi/sbi_hfence.h>
+#include <sbi/sbi_scratch.h>
+#include <sbi/sbi_string.h>
+#include <sbi/sbi_trap.h>
+
+/** Saved S/U-mode state of a domain on one HART */
+struct sbi_domain_context {
+	/** Registers restored on trap return */
+	struct sbi_trap_regs regs;
+	/** S-mode CSRs */
+	unsigned long sie;
+	unsigned long stvec;
+	unsigned long sscratch;
+	unsigned long sepc;
+	unsigned long scause;
+	unsigned long stval;
+	unsigned long sip;
+	unsigned long satp;
+	unsigned long scounteren;
+	unsigned long senvcfg;
+	/** Sstc timer compare CSRs */
+	u64 stimecmp;
+	u64 vstimecmp;
+	/** H-extension CSRs */
+	unsigned long hstatus;
+	unsigned long hedeleg;
+	unsigned long hideleg;
+	unsigned long hie;
+	unsigned long hvip;
+	unsigned long hcounteren;
+	unsigned long hgeie;
+	unsigned long htval;
+	unsigned long htinst;
+	unsigned long hgatp;
+	u64 henvcfg;
+	u64 htimedelta;
+	unsigned long vsstatus;
+	unsigned long vsie;
+	unsigned long vstvec;
+	unsigned long vsscratch;
+	unsigned long vsepc;
+	unsigned long vscause;
+	unsigned long vstval;
+	unsigned long vsip;
+	unsigned long vsatp;
+	/** Floating-point registers, zero when the domain had FP off */
+	u64 fp[32];
+	unsigned long fcsr;
+	/** Context holds state saved by a previous switch */
+	bool saved;
+};
+
+/* Per-HART table of contexts indexed by domain index */
+static unsigned long domain_context_offset;
+
+static struct sbi_domain_context *domain_context_get(
+					struct sbi_scratch *scratch,
+					const struct sbi_domain *dom)
+{
+	struct sbi_domain_context *ctxs;
+	struct sbi_domain *tdom;
+	u32 i, count = 0;
+
+	ctxs = sbi_scratch_read_type(scratch, void *, domain_context_offset);
+	if (!ctxs) {
+		sbi_domain_for_each(i, tdom)
+			count++;
+		ctxs = sbi_calloc(sizeof(*ctxs), count);
+		if (!ctxs)
+			return NULL;
+		sbi_scratch_write_type(scratch, void *,
+				       domain_context_offset, ctxs);
+	}
+
+	return &ctxs[dom->index];
+}
+
+#if __riscv_xlen == 32
+#define domain_csr_read64(csr)						\
+	(((u64)csr_read(csr##H) << 32) | csr_read(csr))
+#define domain_csr_write64(csr, val)					\
+	do {								\
+		csr_write(csr##H, (u64)(val) >> 32);			\
+		csr_write(csr, (u64)(val) & 0xFFFFFFFF);		\
+	} while (0)
+#else
+#define domain_csr_read64(csr)		csr_read(csr)
+#define domain_csr_write64(csr, val)	csr_write(csr, val)
+#endif
+
+static bool domain_context_has_fp(void)
+{
+	return misa_extension('F') || misa_extension('D');
+}
+
+/*
+ * Check that the S/U-mode state of the current domain can be switched
+ * out. Vector registers are not saved so the vector unit must be off,
+ * and so must the FP unit when the firmware is built without FP.
+ */
+static int domain_context_check(const struct sbi_trap_regs *regs)
+{
+	if (regs->mstatus & MSTATUS_VS)
+		return SBI_EDENIED;
+#ifndef __riscv_flen
+	if (domain_context_has_fp() && (regs->mstatus & MSTATUS_FS))
+		return SBI_EDENIED;
+#endif
+
+	return 0;
+}
+
+static void domain_context_fp_save(struct sbi_domain_context *ctx,
+				   const struct sbi_trap_regs *regs)
+{
+	sbi_memset(ctx->fp, 0, sizeof(ctx->fp));
+	ctx->fcsr = 0;
+
+#ifdef __riscv_flen
+	/* FP state of a domain with the FP unit off is not meaningful */
+	if (!domain_context_has_fp() || !(regs->mstatus & MSTATUS_FS))
+		return;
+
+	if (misa_extension('D'))
+		__asm__ __volatile__(
+			".irp n,0,1,2,3,4,5,6,7,8,9,10,11,12,13,14,15,"
+			"16,17,18,19,20,21,22,23,24,25,26,27,28,29,30,31\n"
+			"fsd f\\n, (\\n * 8)(%0)\n"
+			".endr"
+			: : "r"(ctx->fp) : "memory");
+	else
+		__asm__ __volatile__(
+			".irp n,0,1,2,3,4,5,6,7,8,9,10,11,12,13,14,15,"
+			"16,17,18,19,20,21,22,23,24,25,26,27,28,29,30,31\n"
+			"fsw f\\n, (\\n * 8)(%0)\n"
+			".endr"
+			: : "r"(ctx->fp) : "memory");
+	ctx->fcsr = csr_read(CSR_FCSR);
+#endif
+}
+
+/*
+ * FP registers are always reloaded, with zeroes if needed, so that a
+ * domain never sees the values left by another one.
+ */
+static void domain_context_fp_restore(const struct sbi_domain_context *ctx)
+{
+#ifdef __riscv_flen
+	if (!domain_context_has_fp())
+		return;
+
+	/* FS of the restored domain is applied from its mstatus on mret */
+	csr_set(CSR_MSTATUS, MSTATUS_FS);
+	if (misa_extension('D'))
+		__asm__ __volatile__(
+			".irp n,0,1,2,3,4,5,6,7,8,9,10,11,12,13,14,15,"
+			"16,17,18,19,20,21,22,23,24,25,26,27,28,29,30,31\n"
+			"fld f\\n, (\\n * 8)(%0)\n"
+			".endr"
+			: : "r"(ctx->fp) : "memory");
+	else
+		__asm__ __volatile__(
+			".irp n,0,1,2,3,4,5,6,7,8,9,10,11,12,13,14,15,"
+			"16,17,18,19,20,21,22,23,24,25,26,27,28,29,30,31\n"
+			"flw f\\n, (\\n * 8)(%0)\n"
+			".endr"
+			: : "r"(ctx->fp) : "memory");
+	csr_write(CSR_FCSR, ctx->fcsr);
+#endif
+}
+
+static void domain_context_hext_save(struct sbi_scratch *scratch,
+				     struct sbi_domain_context *ctx)
+{
+	ctx->hstatus = csr_read(CSR_HSTATUS);
+	ctx->hedeleg = csr_read(CSR_HEDELEG);
+	ctx->hideleg = csr_read(CSR_HIDELEG);
+	ctx->hie = csr_read(CSR_HIE);
+	ctx->hvip = csr_read(CSR_HVIP);
+	ctx->hcounteren = csr_read(CSR_HCOUNTEREN);
+	ctx->hgeie = csr_read(CSR_HGEIE);
+	ctx->htval = csr_read(CSR_HTVAL);
+	ctx->htinst = csr_read(CSR_HTINST);
+	ctx->hgatp = csr_read(CSR_HGATP);
+	ctx->htimedelta = domain_csr_read64(CSR_HTIMEDELTA);
+	if (sbi_hart_priv_version(scratch) >= SBI_HART_PRIV_VER_1_12)
+		ctx->henvcfg = domain_csr_read64(CSR_HENVCFG);
+	ctx->vsstatus = csr_read(CSR_VSSTATUS);
+	ctx->vsie = csr_read(CSR_VSIE);
+	ctx->vstvec = csr_read(CSR_VSTVEC);
+	ctx->vsscratch = csr_read(CSR_VSSCRATCH);
+	ctx->vsepc = csr_read(CSR_VSEPC);
+	ctx->vscause = csr_read(CSR_VSCAUSE);
+	ctx->vstval = csr_read(CSR_VSTVAL);
+	ctx->vsip = csr_read(CSR_VSIP);
+	ctx->vsatp = csr_read(CSR_VSATP);
+	if (sbi_hart_has_extension(scratch, SBI_HART_EXT_SSTC))
+		ctx->vstimecmp = domain_csr_read64(CSR_VSTIMECMP);
+}
+
+static void domain_context_hext_restore(struct sbi_scratch *scratch,
+					const struct sbi_domain_context *ctx)
+{
+	csr_write(CSR_HSTATUS, ctx->hstatus);
+	csr_write(CSR_HEDELEG, ctx->hedeleg);
+	csr_write(CSR_HIDELEG, ctx->hideleg);
+	csr_write(CSR_HIE, ctx->hie);
+	csr_write(CSR_HVIP, ctx->hvip);
+	csr_write(CSR_HCOUNTEREN, ctx->hcounteren);
+	csr_write(CSR_HGEIE, ctx->hgeie);
+	csr_write(CSR_HTVAL, ctx->htval);
+	csr_write(CSR_HTINST, ctx->htinst);
+	csr_write(CSR_HGATP, ctx->hgatp);
+	domain_csr_write64(CSR_HTIMEDELTA, ctx->htimedelta);
+	if (sbi_hart_priv_version(scratch) >= SBI_HART_PRIV_VER_1_12)
+		domain_csr_write64(CSR_HENVCFG, ctx->henvcfg);
+	csr_write(CSR_VSSTATUS, ctx->vsstatus);
+	csr_write(CSR_VSIE, ctx->vsie);
+	csr_write(CSR_VSTVEC, ctx->vstvec);
+	csr_write(CSR_VSSCRATCH, ctx->vsscratch);
+	csr_write(CSR_VSEPC, ctx->vsepc);
+	csr_write(CSR_VSCAUSE, ctx->vscause);
+	csr_write(CSR_VSTVAL, ctx->vstval);
+	csr_write(CSR_VSIP, ctx->vsip);
+	csr_write(CSR_VSATP, ctx->vsatp);
+	if (sbi_hart_has_extension(scratch, SBI_HART_EXT_SSTC))
+		domain_csr_write64(CSR_VSTIMECMP, ctx->vstimecmp);
+}
+
+static void domain_context_save(struct sbi_scratch *scratch,
+				struct sbi_domain_context *ctx,
+				const struct sbi_trap_regs *regs)
+{
+	sbi_memcpy(&ctx->regs, regs, sizeof(*regs));
+	domain_context_fp_save(ctx, regs);
+
+	if (!misa_extension('S'))
+		goto done;
+
+	ctx->sie = csr_read(CSR_SIE);
+	ctx->stvec = csr_read(CSR_STVEC);
+	ctx->sscratch = csr_read(CSR_SSCRATCH);
+	ctx->sepc = csr_read(CSR_SEPC);
+	ctx->scause = csr_read(CSR_SCAUSE);
+	ctx->stval = csr_read(CSR_STVAL);
+	ctx->sip = csr_read(CSR_SIP);
+	ctx->satp = csr_read(CSR_SATP);
+	ctx->scounteren = csr_read(CSR_SCOUNTEREN);
+	if (sbi_hart_priv_version(scratch) >= SBI_HART_PRIV_VER_1_12)
+		ctx->senvcfg = csr_read(CSR_SENVCFG);
+	if (sbi_hart_has_extension(scratch, SBI_HART_EXT_SSTC))
+		ctx->stimecmp = domain_csr_read64(CSR_STIMECMP);
+	if (misa_extension('H'))
+		domain_context_hext_save(scratch, ctx);
+
+done:
+	ctx->saved = true;
+}
+
+static void domain_context_restore(struct sbi_scratch *scratch,
+				   const struct sbi_domain_context *ctx,
+				   struct sbi_trap_regs *regs)
+{
+	sbi_memcpy(regs, &ctx->regs, sizeof(*regs));
+	domain_context_fp_restore(ctx);
+
+	if (!misa_extension('S'))
+		return;
+
+	csr_write(CSR_SIE, ctx->sie);
+	csr_write(CSR_STVEC, ctx->stvec);
+	csr_write(CSR_SSCRATCH, ctx->sscratch);
+	csr_write(CSR_SEPC, ctx->sepc);
+	csr_write(CSR_SCAUSE, ctx->scause);
+	csr_write(CSR_STVAL, ctx->stval);
+	csr_write(CSR_SIP, ctx->sip);
+	csr_write(CSR_SATP, ctx->satp);
+	csr_write(CSR_SCOUNTEREN, ctx->scounteren);
+	if (sbi_hart_priv_version(scratch) >= SBI_HART_PRIV_VER_1_12)
+		csr_write(CSR_SENVCFG, ctx->senvcfg);
+	if (sbi_hart_has_extension(scratch, SBI_HART_EXT_SSTC))
+		domain_csr_write64(CSR_STIMECMP, ctx->stimecmp);
+	if (misa_extension('H'))
+		domain_context_hext_restore(scratch, ctx);
+}
+
+/* Context entering the next booting stage of a domain */
+static void domain_context_boot(const struct sbi_domain *dom,
+				struct sbi_domain_context *ctx,
+				const struct sbi_trap_regs *regs)
+{
+	unsigned long mstatus = regs->mstatus;
+
+	sbi_memset(ctx, 0, sizeof(*ctx));
+
+	mstatus = INSERT_FIELD(mstatus, MSTATUS_MPP, dom->next_mode);
+	mstatus = INSERT_FIELD(mstatus, MSTATUS_MPIE, 0);
+	mstatus &= ~(MSTATUS_SIE | MSTATUS_SPIE | MSTATUS_SPP);
+#if __riscv_xlen == 32
+	ctx->regs.mstatusH = regs->mstatusH & ~MSTATUSH_MPV;
+#else
+	mstatus &= ~MSTATUS_MPV;
+#endif
+	ctx->regs.mstatus = mstatus;
+	ctx->regs.mepc = dom->next_addr;
+	ctx->regs.a0 = current_hartid();
+	ctx->regs.a1 = dom->next_arg1;
+	ctx->stvec = dom->next_addr;
+	ctx->stimecmp = -1ULL;
+	ctx->vstimecmp = -1ULL;
+#if __riscv_xlen == 64
+	/* Keep the XLEN of lower privilege modes */
+	if (misa_extension('H')) {
+		ctx->hstatus = csr_read(CSR_HSTATUS) & HSTATUS_VSXL;
+		ctx->vsstatus = csr_read(CSR_VSSTATUS) & SSTATUS64_UXL;
+	}
+#endif
+}
+
+int sbi_domain_context_switch(struct sbi_trap_regs *regs,
+			      struct sbi_domain *dom)
+{
+	int rc;
+	bool flush;
+	struct sbi_scratch *scratch = sbi_scratch_thishart_ptr();
+	struct sbi_domain *cur = sbi_domain_thishart_ptr();
+	struct sbi_domain_context *cur_ctx, *next_ctx;
+	u32 hartindex = sbi_hartid_to_hartindex(current_hartid());
+
+	if (!regs || !dom || !cur || !domain_context_offset)
+		return SBI_EINVAL;
+	if (dom == cur)
+		return SBI_EALREADY;
+	if (dom->next_mode != PRV_S && dom->next_mode != PRV_U)
+		return SBI_EDENIED;
+	if (!sbi_domain_switch_allowed(dom, cur, hartindex))
+		return SBI_EDENIED;
+
+	rc = domain_context_check(regs);
+	if (rc)
+		return rc;
+
+	cur_ctx = domain_context_get(scratch, cur);
+	next_ctx = domain_context_get(scratch, dom);
+	if (!cur_ctx || !next_ctx)
+		return SBI_ENOMEM;
+
+	/*
+	 * The PMP switch may fall back to a full configure of the domain
+	 * the HART runs in, so switch the HART first. Nothing else is
+	 * touched until the PMP switch succeeded so that a failure leaves
+	 * the caller running in its own domain.
+	 */
+	rc = sbi_domain_switch_hart(hartindex, dom);
+	if (rc)
+		return rc;
+
+	rc = sbi_hart_pmp_switch(scratch, cur->pmp_image, dom->pmp_image);
+	if (rc) {
+		sbi_domain_switch_hart(hartindex, cur);
+		sbi_hart_pmp_configure(scratch);
+		return rc;
+	}
+
+	domain_context_save(scratch, cur_ctx, regs);
+	if (!next_ctx->saved)
+		domain_context_boot(dom, next_ctx, regs);
+
+	/* Translations of the outgoing domain must not be reused */
+	flush = misa_extension('S') && (cur_ctx->satp & SATP_MODE);
+
+	domain_context_restore(scratch, next_ctx, regs);
+
+	if (flush)
+		__asm__ __volatile__("sfence.vma" : : : "memory");
+	if (misa_extension('H')) {
+		__sbi_hfence_gvma_all();
+		__sbi_hfence_vvma_all();
+	}
+
+	return 0;
+}
+
+int sbi_domain_context_init(void)
+{
+	domain_context_offset = sbi_scratch_alloc_type_offset(void *);
+	if (!domain_context_offset)
+		return SBI_ENOMEM;
+
+	return 0;
+}
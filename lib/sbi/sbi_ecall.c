@@ -11,6 +11,7 @@
 #include <sbi/sbi_ecall.h>
 #include <sbi/sbi_ecall_interface.h>
 #include <sbi/sbi_error.h>
+#include <sbi/sbi_trace.h>
 #include <sbi/sbi_trap.h>
 
 extern struct sbi_ecall_extension *sbi_ecall_exts[];
@@ -114,6 +115,9 @@ int sbi_ecall_handler(struct sbi_trap_regs *regs)
 		ret = SBI_ENOTSUPP;
 	}
 
+	sbi_trace("ecall ext=0x%lx func=0x%lx ret=%ld\n",
+		  extension_id, func_id, (long)ret);
+
 	if (!out.skip_regs_update) {
 		if (ret < SBI_LAST_ERR ||
 		    (extension_id != SBI_EXT_0_1_CONSOLE_GETCHAR &&
@@ -0,0 +1,159 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Copyright (c) 2026 OpenSBI contributors.
+ */
+
+#include <sbi/riscv_asm.h>
+#include <sbi/sbi_boot_prof.h>
+#include <sbi/sbi_domain.h>
+#include <sbi/sbi_domain_context.h>
+#include <sbi/sbi_ecall.h>
+#include <sbi/sbi_ecall_interface.h>
+#include <sbi/sbi_error.h>
+#include <sbi/sbi_hart.h>
+#include <sbi/sbi_hsm.h>
+#include <sbi/sbi_hsm_stats.h>
+#include <sbi/sbi_scratch.h>
+#include <sbi/sbi_trace.h>
+#include <sbi/sbi_trap.h>
+
+static int sbi_ecall_opensbi_trace_read(unsigned long hartid,
+					unsigned long addr_lo,
+					unsigned long addr_hi,
+					unsigned long size,
+					struct sbi_ecall_return *out)
+{
+	int ret;
+	ulong smode = (csr_read(CSR_MSTATUS) & MSTATUS_MPP) >>
+			MSTATUS_MPP_SHIFT;
+
+	/* Same addressing rules as the DBCN extension */
+	if (addr_hi)
+		return SBI_ERR_FAILED;
+
+	if (!sbi_domain_is_assigned_hart(sbi_domain_thishart_ptr(), hartid))
+		return SBI_ERR_INVALID_PARAM;
+
+	if (!sbi_domain_check_addr_range(sbi_domain_thishart_ptr(),
+					 addr_lo, size, smode,
+					 SBI_DOMAIN_READ | SBI_DOMAIN_WRITE))
+		return SBI_ERR_INVALID_ADDRESS;
+
+	sbi_hart_map_saddr(addr_lo, size);
+	ret = sbi_trace_read(hartid, (void *)addr_lo, size);
+	sbi_hart_unmap_saddr();
+	if (ret < 0)
+		return ret;
+
+	out->value = ret;
+	return 0;
+}
+
+static int sbi_ecall_opensbi_boot_profile_read(unsigned long addr_lo,
+					       unsigned long addr_hi,
+					       unsigned long size,
+					       struct sbi_ecall_return *out)
+{
+	int ret;
+	ulong smode = (csr_read(CSR_MSTATUS) & MSTATUS_MPP) >>
+			MSTATUS_MPP_SHIFT;
+
+	if (addr_hi)
+		return SBI_ERR_FAILED;
+
+	if (!sbi_domain_check_addr_range(sbi_domain_thishart_ptr(),
+					 addr_lo, size, smode,
+					 SBI_DOMAIN_READ | SBI_DOMAIN_WRITE))
+		return SBI_ERR_INVALID_ADDRESS;
+
+	sbi_hart_map_saddr(addr_lo, size);
+	ret = sbi_boot_prof_read((void *)addr_lo, size);
+	sbi_hart_unmap_saddr();
+	if (ret < 0)
+		return ret;
+
+	out->value = ret;
+	return 0;
+}
+
+static int sbi_ecall_opensbi_domain_switch(unsigned long index,
+					   struct sbi_trap_regs *regs,
+					   struct sbi_ecall_return *out)
+{
+	int ret;
+	struct sbi_domain *dom;
+
+	if (index >= SBI_DOMAIN_MAX_INDEX)
+		return SBI_ERR_INVALID_PARAM;
+
+	dom = sbi_index_to_domain(index);
+	if (!dom)
+		return SBI_ERR_INVALID_PARAM;
+
+	/* Caller resumes after the ecall when switched back to */
+	regs->mepc += 4;
+	regs->a0 = SBI_SUCCESS;
+	regs->a1 = 0;
+
+	ret = sbi_domain_context_switch(regs, dom);
+	if (ret) {
+		regs->mepc -= 4;
+		return ret;
+	}
+
+	out->skip_regs_update = true;
+	return 0;
+}
+
+static int sbi_ecall_opensbi_hart_start_many(unsigned long hmask,
+					     unsigned long hbase,
+					     unsigned long saddr,
+					     unsigned long arg1)
+{
+	ulong smode = (csr_read(CSR_MSTATUS) & MSTATUS_MPP) >>
+			MSTATUS_MPP_SHIFT;
+
+	return sbi_hsm_hart_start_many(sbi_scratch_thishart_ptr(),
+				       sbi_domain_thishart_ptr(),
+				       hmask, hbase, saddr, smode, arg1);
+}
+
+static int sbi_ecall_opensbi_handler(unsigned long extid, unsigned long funcid,
+				     struct sbi_trap_regs *regs,
+				     struct sbi_ecall_return *out)
+{
+	switch (funcid) {
+	case SBI_EXT_OPENSBI_TRACE_READ:
+		return sbi_ecall_opensbi_trace_read(regs->a0, regs->a1,
+						    regs->a2, regs->a3, out);
+	case SBI_EXT_OPENSBI_DOMAIN_SWITCH:
+		return sbi_ecall_opensbi_domain_switch(regs->a0, regs, out);
+	case SBI_EXT_OPENSBI_HSM_HART_START_MANY:
+		return sbi_ecall_opensbi_hart_start_many(regs->a0, regs->a1,
+							 regs->a2, regs->a3);
+	case SBI_EXT_OPENSBI_HSM_STATS_DUMP:
+		return sbi_hsm_stats_dump(sbi_domain_thishart_ptr());
+	case SBI_EXT_OPENSBI_BOOT_PROFILE_READ:
+		return sbi_ecall_opensbi_boot_profile_read(regs->a0, regs->a1,
+							   regs->a2, out);
+	default:
+		break;
+	}
+
+	return SBI_ENOTSUPP;
+}
+
+struct sbi_ecall_extension ecall_opensbi;
+
+static int sbi_ecall_opensbi_register_extensions(void)
+{
+	return sbi_ecall_register_extension(&ecall_opensbi);
+}
+
+struct sbi_ecall_extension ecall_opensbi = {
+	.extid_start		= SBI_EXT_OPENSBI,
+	.extid_end		= SBI_EXT_OPENSBI,
+	.register_extensions	= sbi_ecall_opensbi_register_extensions,
+	.handle			= sbi_ecall_opensbi_handler,
+};
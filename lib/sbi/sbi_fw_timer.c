@@ -0,0 +1,197 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Copyright (c) 2026 OpenSBI contributors.
+ */
+
+#include <sbi/sbi_error.h>
+#include <sbi/sbi_fw_timer.h>
+#include <sbi/sbi_scratch.h>
+#include <sbi/sbi_string.h>
+#include <sbi/sbi_timer.h>
+
+/*
+ * Per-HART min-heap of queued timers ordered by the latest time at
+ * which each of them must fire.
+ */
+struct fw_timer_queue {
+	u32 count;
+	struct sbi_fw_timer *heap[CONFIG_SBI_FW_TIMER_COUNT];
+};
+
+static unsigned long fw_timer_queue_off;
+
+static struct fw_timer_queue *fw_timer_queue(struct sbi_scratch *scratch)
+{
+	if (!fw_timer_queue_off)
+		return NULL;
+
+	return sbi_scratch_offset_ptr(scratch, fw_timer_queue_off);
+}
+
+static u64 fw_timer_latest(const struct sbi_fw_timer *timer)
+{
+	u64 latest = timer->expires + timer->slack;
+
+	return (latest < timer->expires) ? -1ULL : latest;
+}
+
+static void fw_timer_place(struct fw_timer_queue *q, u32 i,
+			   struct sbi_fw_timer *timer)
+{
+	q->heap[i] = timer;
+	timer->index = i;
+}
+
+static void fw_timer_sift_up(struct fw_timer_queue *q, u32 i)
+{
+	struct sbi_fw_timer *timer = q->heap[i];
+	u32 parent;
+
+	while (i) {
+		parent = (i - 1) / 2;
+		if (fw_timer_latest(q->heap[parent]) <= fw_timer_latest(timer))
+			break;
+		fw_timer_place(q, i, q->heap[parent]);
+		i = parent;
+	}
+	fw_timer_place(q, i, timer);
+}
+
+static void fw_timer_sift_down(struct fw_timer_queue *q, u32 i)
+{
+	struct sbi_fw_timer *timer = q->heap[i];
+	u32 child;
+
+	while ((child = 2 * i + 1) < q->count) {
+		if (child + 1 < q->count &&
+		    fw_timer_latest(q->heap[child + 1]) <
+		    fw_timer_latest(q->heap[child]))
+			child++;
+		if (fw_timer_latest(timer) <= fw_timer_latest(q->heap[child]))
+			break;
+		fw_timer_place(q, i, q->heap[child]);
+		i = child;
+	}
+	fw_timer_place(q, i, timer);
+}
+
+static bool fw_timer_queued(struct fw_timer_queue *q,
+			    struct sbi_fw_timer *timer)
+{
+	return q && timer->index < q->count && q->heap[timer->index] == timer;
+}
+
+static void fw_timer_remove(struct fw_timer_queue *q, u32 i)
+{
+	struct sbi_fw_timer *last = q->heap[--q->count];
+
+	if (i < q->count) {
+		fw_timer_place(q, i, last);
+		fw_timer_sift_up(q, i);
+		fw_timer_sift_down(q, last->index);
+	}
+}
+
+int sbi_fw_timer_add(struct sbi_fw_timer *timer, u64 expires, u64 slack)
+{
+	struct fw_timer_queue *q = fw_timer_queue(sbi_scratch_thishart_ptr());
+	const struct sbi_timer_device *dev = sbi_timer_get_device();
+
+	if (!timer || !timer->fn)
+		return SBI_EINVAL;
+	if (!q || !dev || !dev->timer_event_start)
+		return SBI_ENOTSUPP;
+
+	if (fw_timer_queued(q, timer))
+		fw_timer_remove(q, timer->index);
+	else if (q->count >= CONFIG_SBI_FW_TIMER_COUNT)
+		return SBI_ENOSPC;
+
+	timer->expires = expires;
+	timer->slack = slack;
+	fw_timer_place(q, q->count++, timer);
+	fw_timer_sift_up(q, timer->index);
+
+	sbi_timer_rearm();
+
+	return 0;
+}
+
+void sbi_fw_timer_cancel(struct sbi_fw_timer *timer)
+{
+	struct fw_timer_queue *q = fw_timer_queue(sbi_scratch_thishart_ptr());
+
+	if (!timer || !fw_timer_queued(q, timer))
+		return;
+
+	fw_timer_remove(q, timer->index);
+	sbi_timer_rearm();
+}
+
+bool sbi_fw_timer_pending(struct sbi_fw_timer *timer)
+{
+	return timer &&
+	       fw_timer_queued(fw_timer_queue(sbi_scratch_thishart_ptr()),
+			       timer);
+}
+
+u64 sbi_fw_timer_next(struct sbi_scratch *scratch)
+{
+	struct fw_timer_queue *q = fw_timer_queue(scratch);
+
+	if (!q || !q->count)
+		return -1ULL;
+
+	return fw_timer_latest(q->heap[0]);
+}
+
+void sbi_fw_timer_process(struct sbi_scratch *scratch, u64 now)
+{
+	struct fw_timer_queue *q = fw_timer_queue(scratch);
+	struct sbi_fw_timer *timer;
+	u32 i, budget;
+
+	if (!q)
+		return;
+
+	/*
+	 * Fire every timer which has expired, not only the ones whose
+	 * slack ran out, so that nearby timers share this interrupt.
+	 * A timer re-added as already expired by its callback may fire
+	 * again in this loop. The number of callbacks is bounded by the
+	 * number of timers queued on entry, and whatever is still expired
+	 * after that raises an immediate interrupt once rearmed.
+	 */
+	for (budget = q->count; budget; budget--) {
+		for (i = 0; i < q->count; i++) {
+			if (q->heap[i]->expires <= now)
+				break;
+		}
+		if (i == q->count)
+			break;
+
+		timer = q->heap[i];
+		fw_timer_remove(q, i);
+		timer->fn(timer);
+	}
+}
+
+int sbi_fw_timer_init(struct sbi_scratch *scratch, bool cold_boot)
+{
+	struct fw_timer_queue *q;
+
+	if (cold_boot) {
+		fw_timer_queue_off = sbi_scratch_alloc_offset(sizeof(*q));
+		if (!fw_timer_queue_off)
+			return SBI_ENOMEM;
+	} else if (!fw_timer_queue_off) {
+		return SBI_ENOMEM;
+	}
+
+	/* Timers of a HART do not survive it being stopped */
+	q = fw_timer_queue(scratch);
+	sbi_memset(q, 0, sizeof(*q));
+
+	return 0;
+}
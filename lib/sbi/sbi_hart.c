@@ -11,12 +11,14 @@
 #include <sbi/riscv_barrier.h>
 #include <sbi/riscv_encoding.h>
 #include <sbi/riscv_fp.h>
+#include <sbi/riscv_locks.h>
 #include <sbi/sbi_bitops.h>
 #include <sbi/sbi_console.h>
 #include <sbi/sbi_domain.h>
 #include <sbi/sbi_csr_detect.h>
 #include <sbi/sbi_error.h>
 #include <sbi/sbi_hart.h>
+#include <sbi/sbi_heap.h>
 #include <sbi/sbi_math.h>
 #include <sbi/sbi_platform.h>
 #include <sbi/sbi_pmu.h>
@@ -31,12 +33,77 @@ void (*sbi_hart_expected_trap)(void) = &__sbi_expected_trap;
 
 static unsigned long hart_features_offset;
 
-static void mstatus_init(struct sbi_scratch *scratch)
+/* Shared memory window programmed in the Smepmp reserved PMP entry */
+struct hart_saddr_window {
+	/* Window is left programmed while no buffer is mapped */
+	bool cached;
+	/* Window may stay programmed after unmap */
+	bool keep;
+	unsigned long base;
+	unsigned long order;
+};
+
+static unsigned long hart_saddr_window_offset;
+
+/* M-mode CSR state of a fully initialized hart replayed on resume */
+struct hart_resume_state {
+	bool valid;
+	/* Domain of the hart when the state was saved */
+	const struct sbi_domain *dom;
+	/* Which of the optional CSRs below were saved */
+	bool has_smode;
+	bool has_mcounteren;
+	bool has_mcountinhibit;
+	bool has_menvcfg;
+	bool has_mseccfg;
+	bool has_mstateen;
+	unsigned long mstatus;
+	unsigned long mtvec;
+	unsigned long medeleg;
+	unsigned long mideleg;
+	unsigned long mcounteren;
+	unsigned long scounteren;
+	unsigned long mcountinhibit;
+	unsigned long menvcfg;
+	unsigned long mstateen0;
+#if __riscv_xlen == 32
+	unsigned long menvcfgh;
+	unsigned long mstateen0h;
+#endif
+	unsigned long mseccfg_seed;
+};
+
+static unsigned long hart_resume_state_offset;
+
+static void mhpmevent_init(struct sbi_scratch *scratch)
 {
 	int cidx;
-	unsigned long mstatus_val = 0;
 	unsigned int mhpm_mask = sbi_hart_mhpm_mask(scratch);
 	uint64_t mhpmevent_init_val = 0;
+
+	/**
+	 * The mhpmeventn[h] CSR should be initialized with interrupt disabled
+	 * and inhibited running in M-mode during init.
+	 */
+	mhpmevent_init_val |= (MHPMEVENT_OF | MHPMEVENT_MINH);
+	for (cidx = 0; cidx <= 28; cidx++) {
+		if (!(mhpm_mask & 1 << (cidx + 3)))
+			continue;
+#if __riscv_xlen == 32
+		csr_write_num(CSR_MHPMEVENT3 + cidx,
+			       mhpmevent_init_val & 0xFFFFFFFF);
+		if (sbi_hart_has_extension(scratch, SBI_HART_EXT_SSCOFPMF))
+			csr_write_num(CSR_MHPMEVENT3H + cidx,
+				      mhpmevent_init_val >> BITS_PER_LONG);
+#else
+		csr_write_num(CSR_MHPMEVENT3 + cidx, mhpmevent_init_val);
+#endif
+	}
+}
+
+static void mstatus_init(struct sbi_scratch *scratch)
+{
+	unsigned long mstatus_val = 0;
 	uint64_t menvcfg_val, mstateen_val;
 
 	/* Enable FPU */
@@ -66,24 +133,7 @@ static void mstatus_init(struct sbi_scratch *scratch)
 	if (sbi_hart_priv_version(scratch) >= SBI_HART_PRIV_VER_1_11)
 		csr_write(CSR_MCOUNTINHIBIT, 0xFFFFFFF8);
 
-	/**
-	 * The mhpmeventn[h] CSR should be initialized with interrupt disabled
-	 * and inhibited running in M-mode during init.
-	 */
-	mhpmevent_init_val |= (MHPMEVENT_OF | MHPMEVENT_MINH);
-	for (cidx = 0; cidx <= 28; cidx++) {
-		if (!(mhpm_mask & 1 << (cidx + 3)))
-			continue;
-#if __riscv_xlen == 32
-		csr_write_num(CSR_MHPMEVENT3 + cidx,
-			       mhpmevent_init_val & 0xFFFFFFFF);
-		if (sbi_hart_has_extension(scratch, SBI_HART_EXT_SSCOFPMF))
-			csr_write_num(CSR_MHPMEVENT3H + cidx,
-				      mhpmevent_init_val >> BITS_PER_LONG);
-#else
-		csr_write_num(CSR_MHPMEVENT3 + cidx, mhpmevent_init_val);
-#endif
-	}
+	mhpmevent_init(scratch);
 
 	if (sbi_hart_has_extension(scratch, SBI_HART_EXT_SMSTATEEN)) {
 		mstateen_val = csr_read(CSR_MSTATEEN0);
@@ -271,8 +321,8 @@ unsigned int sbi_hart_mhpm_bits(struct sbi_scratch *scratch)
  * Returns Smepmp flags for a given domain and region based on permissions.
  */
 static unsigned int sbi_hart_get_smepmp_flags(struct sbi_scratch *scratch,
-					      struct sbi_domain *dom,
-					      struct sbi_domain_memregion *reg)
+					      const struct sbi_domain *dom,
+					      const struct sbi_domain_memregion *reg)
 {
 	unsigned int pmp_flags = 0;
 
@@ -425,6 +475,31 @@ static int sbi_hart_smepmp_configure(struct sbi_scratch *scratch,
 	return 0;
 }
 
+/*
+ * Returns legacy PMP flags for a given region based on permissions.
+ */
+static unsigned int sbi_hart_get_oldpmp_flags(
+				const struct sbi_domain_memregion *reg)
+{
+	unsigned int pmp_flags = 0;
+
+	/*
+	 * If permissions are to be enforced for all modes on
+	 * this region, the lock bit should be set.
+	 */
+	if (reg->flags & SBI_DOMAIN_MEMREGION_ENF_PERMISSIONS)
+		pmp_flags |= PMP_L;
+
+	if (reg->flags & SBI_DOMAIN_MEMREGION_SU_READABLE)
+		pmp_flags |= PMP_R;
+	if (reg->flags & SBI_DOMAIN_MEMREGION_SU_WRITABLE)
+		pmp_flags |= PMP_W;
+	if (reg->flags & SBI_DOMAIN_MEMREGION_SU_EXECUTABLE)
+		pmp_flags |= PMP_X;
+
+	return pmp_flags;
+}
+
 static int sbi_hart_oldpmp_configure(struct sbi_scratch *scratch,
 				     unsigned int pmp_count,
 				     unsigned int pmp_log2gran,
@@ -440,21 +515,7 @@ static int sbi_hart_oldpmp_configure(struct sbi_scratch *scratch,
 		if (pmp_count <= pmp_idx)
 			break;
 
-		pmp_flags = 0;
-
-		/*
-		 * If permissions are to be enforced for all modes on
-		 * this region, the lock bit should be set.
-		 */
-		if (reg->flags & SBI_DOMAIN_MEMREGION_ENF_PERMISSIONS)
-			pmp_flags |= PMP_L;
-
-		if (reg->flags & SBI_DOMAIN_MEMREGION_SU_READABLE)
-			pmp_flags |= PMP_R;
-		if (reg->flags & SBI_DOMAIN_MEMREGION_SU_WRITABLE)
-			pmp_flags |= PMP_W;
-		if (reg->flags & SBI_DOMAIN_MEMREGION_SU_EXECUTABLE)
-			pmp_flags |= PMP_X;
+		pmp_flags = sbi_hart_get_oldpmp_flags(reg);
 
 		pmp_addr = reg->base >> PMP_SHIFT;
 		if (pmp_log2gran <= reg->order && pmp_addr < pmp_addr_max) {
@@ -470,19 +531,78 @@ static int sbi_hart_oldpmp_configure(struct sbi_scratch *scratch,
 	return 0;
 }
 
+static inline struct hart_saddr_window *hart_saddr_window_ptr(
+						struct sbi_scratch *scratch)
+{
+	if (!hart_saddr_window_offset)
+		return NULL;
+
+	return sbi_scratch_offset_ptr(scratch, hart_saddr_window_offset);
+}
+
+void sbi_hart_saddr_invalidate(struct sbi_scratch *scratch)
+{
+	struct hart_saddr_window *win = hart_saddr_window_ptr(scratch);
+
+	if (!win || !win->cached)
+		return;
+
+	win->cached = false;
+	pmp_disable(SBI_SMEPMP_RESV_ENTRY);
+}
+
+/*
+ * The window grants S-mode read/write but no execute access and it has
+ * priority over all domain regions. It can only stay programmed across
+ * the return to S-mode if the domain already grants S-mode read/write
+ * access to all of it and S-mode execute access to none of it.
+ */
+static bool hart_saddr_window_keep(const struct sbi_domain *dom,
+				   unsigned long base, unsigned long order)
+{
+	const struct sbi_domain_memregion *reg;
+	unsigned long end = base + (1UL << order) - 1;
+
+	if (!dom || !sbi_domain_check_addr_range(dom, base, 1UL << order,
+				PRV_S, SBI_DOMAIN_READ | SBI_DOMAIN_WRITE))
+		return false;
+
+	sbi_domain_for_each_memregion(dom, reg) {
+		if (!(reg->flags & SBI_DOMAIN_MEMREGION_SU_EXECUTABLE))
+			continue;
+		if (reg->order >= __riscv_xlen ||
+		    (reg->base <= end &&
+		     base <= reg->base + (1UL << reg->order) - 1))
+			return false;
+	}
+
+	return true;
+}
+
 int sbi_hart_map_saddr(unsigned long addr, unsigned long size)
 {
 	/* shared R/W access for M and S/U mode */
 	unsigned int pmp_flags = (PMP_W | PMP_X);
 	unsigned long order, base = 0;
 	struct sbi_scratch *scratch = sbi_scratch_thishart_ptr();
+	struct hart_saddr_window *win;
 
 	/* If Smepmp is not supported no special mapping is required */
 	if (!sbi_hart_has_extension(scratch, SBI_HART_EXT_SMEPMP))
 		return SBI_OK;
 
-	if (is_pmp_entry_mapped(SBI_SMEPMP_RESV_ENTRY))
+	win = hart_saddr_window_ptr(scratch);
+	if (win && win->cached) {
+		/* Reuse the window left programmed if it covers the buffer */
+		if (win->base <= addr && size &&
+		    addr + size - 1 <= win->base + (1UL << win->order) - 1) {
+			win->cached = false;
+			return SBI_OK;
+		}
+		sbi_hart_saddr_invalidate(scratch);
+	} else if (is_pmp_entry_mapped(SBI_SMEPMP_RESV_ENTRY)) {
 		return SBI_ENOSPC;
+	}
 
 	for (order = MAX(sbi_hart_pmp_log2gran(scratch), log2roundup(size));
 	     order <= __riscv_xlen; order++) {
@@ -500,34 +620,247 @@ int sbi_hart_map_saddr(unsigned long addr, unsigned long size)
 
 	pmp_set(SBI_SMEPMP_RESV_ENTRY, pmp_flags, base, order);
 
+	if (win) {
+		win->base = base;
+		win->order = order;
+		win->keep = hart_saddr_window_keep(sbi_domain_thishart_ptr(),
+						   base, order);
+	}
+
 	return SBI_OK;
 }
 
 int sbi_hart_unmap_saddr(void)
 {
 	struct sbi_scratch *scratch = sbi_scratch_thishart_ptr();
+	struct hart_saddr_window *win;
 
 	if (!sbi_hart_has_extension(scratch, SBI_HART_EXT_SMEPMP))
 		return SBI_OK;
 
+	/* Windows which only cover S-mode data of the domain can stay */
+	win = hart_saddr_window_ptr(scratch);
+	if (win && win->keep && is_pmp_entry_mapped(SBI_SMEPMP_RESV_ENTRY)) {
+		win->cached = true;
+		return SBI_OK;
+	}
+
 	return pmp_disable(SBI_SMEPMP_RESV_ENTRY);
 }
 
+static void hart_pmp_fence(void)
+{
+	if (misa_extension('S')) {
+		__asm__ __volatile__("sfence.vma");
+
+		/*
+		 * If hypervisor mode is supported, flush caching
+		 * structures in guest mode too.
+		 */
+		if (misa_extension('H'))
+			__sbi_hfence_gvma_all();
+	}
+}
+
+static inline unsigned long hart_pmp_image_cfg(
+				const struct sbi_hart_pmp_image *img,
+				unsigned int pmp_idx)
+{
+	return (img->cfg[pmp_idx / PMP_CFG_PER_REG] >>
+		((pmp_idx % PMP_CFG_PER_REG) * 8)) & 0xffUL;
+}
+
+static bool hart_pmp_image_set(struct sbi_hart_pmp_image *img,
+			       const struct sbi_domain *dom,
+			       const struct sbi_domain_memregion *reg,
+			       unsigned int pmp_idx, unsigned int pmp_flags,
+			       unsigned long pmp_addr_max)
+{
+	unsigned int shift = (pmp_idx % PMP_CFG_PER_REG) * 8;
+	unsigned long cfg, pmpaddr;
+
+	if (reg->order < img->pmp_log2gran ||
+	    pmp_addr_max <= (reg->base >> PMP_SHIFT) ||
+	    pmp_encode(pmp_flags, reg->base, reg->order, &cfg, &pmpaddr)) {
+		sbi_printf("Can not configure pmp for domain %s because"
+			   " memory region address 0x%lx or size 0x%lx "
+			   "is not in range.\n", dom->name, reg->base,
+			   reg->order);
+		return false;
+	}
+
+	img->cfg[pmp_idx / PMP_CFG_PER_REG] |= cfg << shift;
+	if (img->smepmp && SBI_DOMAIN_MEMREGION_M_ONLY_ACCESS(reg->flags))
+		img->mcfg[pmp_idx / PMP_CFG_PER_REG] |= cfg << shift;
+	img->addr[pmp_idx] = pmpaddr;
+	img->used = pmp_idx + 1;
+
+	return true;
+}
+
+/*
+ * Merge pairs of regions with same flags which together form a
+ * naturally aligned region of twice the size. The merged region takes
+ * the position of the later region of the pair so every region still
+ * comes before the regions containing it and the first matching PMP
+ * entry of any address keeps the same permissions.
+ */
+static u32 hart_pmp_merge_regions(struct sbi_domain_memregion *regs,
+				  u32 count)
+{
+	struct sbi_domain_memregion *a, *b;
+	bool merged;
+	u32 i, j;
+
+	do {
+		merged = false;
+		for (i = 0; i < count && !merged; i++) {
+			a = &regs[i];
+			for (j = i + 1; j < count; j++) {
+				b = &regs[j];
+				if (a->order != b->order ||
+				    a->order >= __riscv_xlen ||
+				    a->flags != b->flags ||
+				    (a->base ^ b->base) != (1UL << a->order))
+					continue;
+
+				b->base &= ~(1UL << b->order);
+				b->order++;
+				sbi_memmove(a, a + 1,
+					    (count - i - 1) * sizeof(*a));
+				count--;
+				merged = true;
+				break;
+			}
+		}
+	} while (merged);
+
+	sbi_memset(&regs[count], 0, sizeof(*regs));
+
+	return count;
+}
+
+int sbi_hart_pmp_image_build(struct sbi_scratch *scratch,
+			     const struct sbi_domain *dom,
+			     struct sbi_hart_pmp_image *img)
+{
+	const struct sbi_domain_memregion *reg;
+	struct sbi_domain_memregion *regs;
+	unsigned int pmp_bits, pmp_idx = 0, pmp_flags;
+	unsigned long pmp_addr_max;
+	u32 count = 0, avail;
+
+	if (!dom || !img)
+		return SBI_EINVAL;
+
+	sbi_memset(img, 0, sizeof(*img));
+	img->pmp_count = sbi_hart_pmp_count(scratch);
+	img->pmp_log2gran = sbi_hart_pmp_log2gran(scratch);
+	img->pmp_addr_bits = sbi_hart_pmp_addrbits(scratch);
+	img->smepmp = sbi_hart_has_extension(scratch, SBI_HART_EXT_SMEPMP);
+	if (!img->pmp_count)
+		return 0;
+
+	pmp_bits = img->pmp_addr_bits - 1;
+	pmp_addr_max = (1UL << pmp_bits) | ((1UL << pmp_bits) - 1);
+
+	/* Work on a merged copy, the domain regions stay untouched */
+	sbi_domain_for_each_memregion(dom, reg)
+		count++;
+	regs = sbi_calloc(sizeof(*regs), count + 1);
+	if (!regs)
+		return SBI_ENOMEM;
+	sbi_memcpy(regs, dom->regions, count * sizeof(*regs));
+	count = hart_pmp_merge_regions(regs, count);
+
+	/* A truncated image would leave regions of the domain unenforced */
+	avail = img->pmp_count - (img->smepmp ? 1 : 0);
+	if (avail < count) {
+		sbi_printf("%s: domain %s needs %u PMP entries but only %u "
+			   "are available\n", __func__, dom->name, count, avail);
+		sbi_free(regs);
+		return SBI_ENOSPC;
+	}
+
+	/* Same entry assignment as sbi_hart_pmp_configure() */
+	for (reg = regs; reg->order; reg++) {
+		if (img->smepmp && pmp_idx == SBI_SMEPMP_RESV_ENTRY)
+			pmp_idx++;
+		if (img->pmp_count <= pmp_idx)
+			break;
+
+		if (img->smepmp) {
+			pmp_flags = sbi_hart_get_smepmp_flags(scratch, dom, reg);
+			if (!pmp_flags)
+				break;
+			hart_pmp_image_set(img, dom, reg, pmp_idx++, pmp_flags,
+					   pmp_addr_max);
+		} else {
+			pmp_flags = sbi_hart_get_oldpmp_flags(reg);
+			if (hart_pmp_image_set(img, dom, reg, pmp_idx,
+					       pmp_flags, pmp_addr_max))
+				pmp_idx++;
+		}
+	}
+
+	sbi_free(regs);
+
+	return 0;
+}
+
+static bool hart_pmp_image_usable(struct sbi_scratch *scratch,
+				  const struct sbi_hart_pmp_image *img)
+{
+	return img && img->pmp_count == sbi_hart_pmp_count(scratch) &&
+	       img->pmp_log2gran == sbi_hart_pmp_log2gran(scratch) &&
+	       img->pmp_addr_bits == sbi_hart_pmp_addrbits(scratch) &&
+	       img->smepmp == sbi_hart_has_extension(scratch,
+						     SBI_HART_EXT_SMEPMP);
+}
+
+static void sbi_hart_pmp_image_configure(const struct sbi_hart_pmp_image *img)
+{
+	/*
+	 * Set the RLB before any write so that, we can write to PMP
+	 * entries without enforcement even if some entries are locked.
+	 * Keep it set so that dynamic mappings can be done.
+	 */
+	if (img->smepmp)
+		csr_set(CSR_MSECCFG, MSECCFG_RLB);
+
+	pmpaddr_write_all(img->addr, img->pmp_count);
+
+	if (img->smepmp) {
+		/* Program M-only regions before setting MML */
+		pmpcfg_write_all(img->mcfg, img->pmp_count);
+		csr_set(CSR_MSECCFG, MSECCFG_MML);
+	}
+
+	pmpcfg_write_all(img->cfg, img->pmp_count);
+}
+
 int sbi_hart_pmp_configure(struct sbi_scratch *scratch)
 {
-	int rc;
+	int rc = 0;
 	unsigned int pmp_bits, pmp_log2gran;
 	unsigned int pmp_count = sbi_hart_pmp_count(scratch);
 	unsigned long pmp_addr_max;
+	struct sbi_domain *dom = sbi_domain_thishart_ptr();
 
 	if (!pmp_count)
 		return 0;
 
+	/* PMP granularity may differ from the one windows were computed for */
+	sbi_hart_saddr_invalidate(scratch);
+
 	pmp_log2gran = sbi_hart_pmp_log2gran(scratch);
 	pmp_bits = sbi_hart_pmp_addrbits(scratch) - 1;
 	pmp_addr_max = (1UL << pmp_bits) | ((1UL << pmp_bits) - 1);
 
-	if (sbi_hart_has_extension(scratch, SBI_HART_EXT_SMEPMP))
+	/* Use precomputed entries unless this HART has a different PMP */
+	if (dom && hart_pmp_image_usable(scratch, dom->pmp_image))
+		sbi_hart_pmp_image_configure(dom->pmp_image);
+	else if (sbi_hart_has_extension(scratch, SBI_HART_EXT_SMEPMP))
 		rc = sbi_hart_smepmp_configure(scratch, pmp_count,
 						pmp_log2gran, pmp_addr_max);
 	else
@@ -544,18 +877,88 @@ int sbi_hart_pmp_configure(struct sbi_scratch *scratch)
 	 * It is advisable to flush the caching structures under such
 	 * conditions.
 	 */
-	if (misa_extension('S')) {
-		__asm__ __volatile__("sfence.vma");
+	hart_pmp_fence();
+
+	return rc;
+}
+
+static bool hart_pmp_has_locked(unsigned int pmp_count)
+{
+	unsigned long prot, addr, log2len;
+	unsigned int i;
+
+	for (i = 0; i < pmp_count; i++) {
+		if (!pmp_get(i, &prot, &addr, &log2len) && (prot & PMP_L))
+			return true;
+	}
+
+	return false;
+}
+
+int sbi_hart_pmp_switch(struct sbi_scratch *scratch,
+			const struct sbi_hart_pmp_image *from,
+			const struct sbi_hart_pmp_image *to)
+{
+	unsigned int i, pmp_count = sbi_hart_pmp_count(scratch);
+	unsigned long from_cfg, to_cfg;
+	bool reduced = false;
+
+	if (!pmp_count)
+		return 0;
+
+	/* Images computed for a different PMP layout can't be used */
+	if (!hart_pmp_image_usable(scratch, from) ||
+	    !hart_pmp_image_usable(scratch, to)) {
+		if (!sbi_hart_has_extension(scratch, SBI_HART_EXT_SMEPMP) &&
+		    hart_pmp_has_locked(pmp_count))
+			return SBI_EDENIED;
+		return sbi_hart_pmp_configure(scratch);
+	}
+
+	/*
+	 * Without Smepmp, writes to locked entries are silently ignored
+	 * until reset so fail before touching any entry.
+	 */
+	if (!to->smepmp) {
+		for (i = 0; i < pmp_count; i++) {
+			from_cfg = hart_pmp_image_cfg(from, i);
+			to_cfg = hart_pmp_image_cfg(to, i);
+			if ((from_cfg & PMP_L) &&
+			    (from_cfg != to_cfg || from->addr[i] != to->addr[i]))
+				return SBI_EDENIED;
+		}
+	}
+
+	for (i = 0; i < pmp_count; i++) {
+		if (to->smepmp && i == SBI_SMEPMP_RESV_ENTRY)
+			continue;
+		from_cfg = hart_pmp_image_cfg(from, i);
+		to_cfg = hart_pmp_image_cfg(to, i);
+		if (from_cfg == to_cfg && from->addr[i] == to->addr[i])
+			continue;
 
 		/*
-		 * If hypervisor mode is supported, flush caching
-		 * structures in guest mode too.
+		 * Rewriting an entry which is enabled or which takes priority
+		 * over an enabled one can revoke permissions, and so can a
+		 * new locked entry.
 		 */
-		if (misa_extension('H'))
-			__sbi_hfence_gvma_all();
+		if (i < from->used || (to_cfg & PMP_L))
+			reduced = true;
+
+		pmp_set_raw(i, to_cfg, to->addr[i]);
 	}
 
-	return rc;
+	/* Shared memory window of previous domain must not stay mapped */
+	if (to->smepmp) {
+		sbi_hart_saddr_invalidate(scratch);
+		pmp_disable(SBI_SMEPMP_RESV_ENTRY);
+	}
+
+	/* Cached translations only need flushing if permissions shrink */
+	if (reduced)
+		hart_pmp_fence();
+
+	return 0;
 }
 
 int sbi_hart_priv_version(struct sbi_scratch *scratch)
@@ -615,8 +1018,15 @@ void sbi_hart_update_extension(struct sbi_scratch *scratch,
 {
 	struct sbi_hart_features *hfeatures =
 			sbi_scratch_offset_ptr(scratch, hart_features_offset);
+	struct hart_resume_state *rs;
 
 	__sbi_hart_update_extension(hfeatures, ext, enable);
+
+	/* Saved resume state no longer matches the hart features */
+	if (hart_resume_state_offset) {
+		rs = sbi_scratch_offset_ptr(scratch, hart_resume_state_offset);
+		rs->valid = false;
+	}
 }
 
 /**
@@ -638,6 +1048,124 @@ bool sbi_hart_has_extension(struct sbi_scratch *scratch,
 		return false;
 }
 
+/* WRS.NTO and WRS.STO encodings (Zawrs) */
+#define WRS_NTO		".word 0x00d00073"
+#define WRS_STO		".word 0x01d00073"
+
+static bool hart_has_zawrs(void)
+{
+#ifdef __riscv_zawrs
+	/* Firmware is built for an ISA which includes Zawrs */
+	return true;
+#else
+	struct sbi_hart_features *hfeatures;
+
+	/* Zawrs can only be used once features of this HART are known */
+	if (!hart_features_offset)
+		return false;
+
+	hfeatures = sbi_scratch_offset_ptr(sbi_scratch_thishart_ptr(),
+					   hart_features_offset);
+	return hfeatures->detected &&
+	       __test_bit(SBI_HART_EXT_ZAWRS, hfeatures->extensions);
+#endif
+}
+
+/** Check whether the current HART can use sbi_hart_wait_on_xyz() */
+bool sbi_hart_can_wait_on_addr(void)
+{
+	return hart_has_zawrs();
+}
+
+/**
+ * Stall the current HART while a 32-bit word still holds a given value
+ *
+ * The HART registers a reservation on the word and waits in a low-power
+ * state using Zawrs until the word is written, an interrupt is pending
+ * or (with timeout) an implementation defined short duration elapsed.
+ * The wait may end spuriously so callers must re-check the word.
+ *
+ * Must only be used if sbi_hart_can_wait_on_addr() returned true.
+ */
+void __sbi_hart_wait_on_u32(volatile u32 *addr, u32 val, bool timeout)
+{
+	u32 tmp;
+
+	if (timeout)
+		__asm__ __volatile__("	lr.w	%0, %1\n"
+				     "	bne	%0, %2, 1f\n"
+				     "	" WRS_STO "\n"
+				     "1:\n"
+				     : "=&r"(tmp), "+A"(*addr)
+				     : "r"(val)
+				     : "memory");
+	else
+		__asm__ __volatile__("	lr.w	%0, %1\n"
+				     "	bne	%0, %2, 1f\n"
+				     "	" WRS_NTO "\n"
+				     "1:\n"
+				     : "=&r"(tmp), "+A"(*addr)
+				     : "r"(val)
+				     : "memory");
+}
+
+/** Same as __sbi_hart_wait_on_u32() but for a XLEN sized word */
+void __sbi_hart_wait_on_ulong(volatile unsigned long *addr,
+			      unsigned long val, bool timeout)
+{
+	unsigned long tmp;
+
+	if (timeout)
+		__asm__ __volatile__("	" REG_LR "	%0, %1\n"
+				     "	bne	%0, %2, 1f\n"
+				     "	" WRS_STO "\n"
+				     "1:\n"
+				     : "=&r"(tmp), "+A"(*addr)
+				     : "r"(val)
+				     : "memory");
+	else
+		__asm__ __volatile__("	" REG_LR "	%0, %1\n"
+				     "	bne	%0, %2, 1f\n"
+				     "	" WRS_NTO "\n"
+				     "1:\n"
+				     : "=&r"(tmp), "+A"(*addr)
+				     : "r"(val)
+				     : "memory");
+}
+
+/**
+ * Stall the current HART while a 32-bit word still holds a given value
+ *
+ * Same as __sbi_hart_wait_on_u32() for callers which wait only once.
+ * Loops should check sbi_hart_can_wait_on_addr() before the loop.
+ *
+ * @return false if the HART can't wait on address (caller should
+ * fall back to its own polling or WFI) and true otherwise
+ */
+bool sbi_hart_wait_on_u32(volatile u32 *addr, u32 val, bool timeout)
+{
+	if (!hart_has_zawrs())
+		return false;
+
+	__sbi_hart_wait_on_u32(addr, val, timeout);
+	return true;
+}
+
+/**
+ * Stall the current HART while an unsigned long still holds a given value
+ *
+ * Same as sbi_hart_wait_on_u32() but for a XLEN sized word.
+ */
+bool sbi_hart_wait_on_ulong(volatile unsigned long *addr, unsigned long val,
+			    bool timeout)
+{
+	if (!hart_has_zawrs())
+		return false;
+
+	__sbi_hart_wait_on_ulong(addr, val, timeout);
+	return true;
+}
+
 #define __SBI_HART_EXT_DATA(_name, _id) {	\
 	.name = #_name,				\
 	.id = _id,				\
@@ -658,6 +1186,7 @@ const struct sbi_hart_ext_data sbi_hart_ext[] = {
 	__SBI_HART_EXT_DATA(zicbom, SBI_HART_EXT_ZICBOM),
 	__SBI_HART_EXT_DATA(svpbmt, SBI_HART_EXT_SVPBMT),
 	__SBI_HART_EXT_DATA(sdtrig, SBI_HART_EXT_SDTRIG),
+	__SBI_HART_EXT_DATA(zawrs, SBI_HART_EXT_ZAWRS),
 };
 
 /**
@@ -743,18 +1272,28 @@ static int hart_mhpm_get_allowed_bits(void)
 	return num_bits;
 }
 
-static int hart_detect_features(struct sbi_scratch *scratch)
+static void hart_detect_zawrs(struct sbi_trap_info *trap)
+{
+	register ulong tinfo asm("a3") = (ulong)trap;
+	register ulong ttmp asm("a4");
+	register ulong mtvec = sbi_hart_expected_trap_addr();
+
+	trap->cause = 0;
+	asm volatile(
+		"add %[ttmp], %[tinfo], zero\n"
+		"csrrw %[mtvec], " STR(CSR_MTVEC) ", %[mtvec]\n"
+		WRS_STO "\n"
+		"csrw " STR(CSR_MTVEC) ", %[mtvec]"
+	    : [mtvec] "+&r"(mtvec), [tinfo] "+&r"(tinfo),
+	      [ttmp] "+&r"(ttmp)
+	    :
+	    : "memory");
+}
+
+static void hart_probe_features(struct sbi_hart_features *hfeatures)
 {
 	struct sbi_trap_info trap = {0};
-	struct sbi_hart_features *hfeatures =
-		sbi_scratch_offset_ptr(scratch, hart_features_offset);
 	unsigned long val, oldval;
-	bool has_zicntr = false;
-	int rc;
-
-	/* If hart features already detected then do nothing */
-	if (hfeatures->detected)
-		return 0;
 
 	/* Clear hart features */
 	sbi_memset(hfeatures->extensions, 0, sizeof(hfeatures->extensions));
@@ -905,6 +1444,171 @@ __pmp_skip:
 
 #undef __check_ext_csr
 
+	/*
+	 * Detect if hart supports Zawrs. Without a reservation WRS.STO
+	 * completes immediately and otherwise it is an illegal instruction.
+	 */
+	hart_detect_zawrs(&trap);
+	if (!trap.cause)
+		__sbi_hart_update_extension(hfeatures,
+					    SBI_HART_EXT_ZAWRS, true);
+}
+
+#ifdef CONFIG_SBI_HART_FEATURES_SHARE
+
+#define HART_FEATURES_CLASS_MAX		4
+
+/* Trap detected features shared by HARTs with the same IDs */
+struct hart_features_class {
+	bool valid;
+	unsigned long mvendorid;
+	unsigned long marchid;
+	unsigned long mimpid;
+	struct sbi_hart_features features;
+};
+
+static struct hart_features_class hart_features_classes[HART_FEATURES_CLASS_MAX];
+static spinlock_t hart_features_classes_lock = SPIN_LOCK_INITIALIZER;
+
+static struct hart_features_class *hart_features_class_find(bool alloc)
+{
+	struct hart_features_class *fc;
+	unsigned long mvendorid = csr_read(CSR_MVENDORID);
+	unsigned long marchid = csr_read(CSR_MARCHID);
+	unsigned long mimpid = csr_read(CSR_MIMPID);
+	int i;
+
+	/* HARTs can't be told apart if the IDs are not implemented */
+	if (!mvendorid && !marchid && !mimpid)
+		return NULL;
+
+	for (i = 0; i < HART_FEATURES_CLASS_MAX; i++) {
+		fc = &hart_features_classes[i];
+		if (!fc->valid) {
+			if (!alloc)
+				return NULL;
+			fc->mvendorid = mvendorid;
+			fc->marchid = marchid;
+			fc->mimpid = mimpid;
+			return fc;
+		}
+		if (fc->mvendorid == mvendorid && fc->marchid == marchid &&
+		    fc->mimpid == mimpid)
+			return fc;
+	}
+
+	return NULL;
+}
+
+#ifdef CONFIG_SBI_HART_FEATURES_VERIFY
+/*
+ * Re-probe a small subset of the features. The probes use the
+ * csr_*_allowed() accessors which may take and recover from a trap,
+ * but this costs far fewer CSR accesses than full feature detection.
+ */
+static bool hart_features_verify(const struct sbi_hart_features *hfeatures)
+{
+	struct sbi_trap_info trap = {0};
+	unsigned long val = hart_pmp_get_allowed_addr();
+
+	if (!val != !hfeatures->pmp_count)
+		return false;
+	if (val && (hfeatures->pmp_log2gran != sbi_ffs(val) + 2 ||
+		    hfeatures->pmp_addr_bits != sbi_fls(val) + 1))
+		return false;
+
+	if (hfeatures->mhpm_bits != hart_mhpm_get_allowed_bits())
+		return false;
+
+	switch (hfeatures->priv_version) {
+	case SBI_HART_PRIV_VER_1_12:
+		csr_read_allowed(CSR_MENVCFG, (ulong)&trap);
+		break;
+	case SBI_HART_PRIV_VER_1_11:
+		csr_read_allowed(CSR_MCOUNTINHIBIT, (ulong)&trap);
+		break;
+	case SBI_HART_PRIV_VER_1_10:
+		csr_read_allowed(CSR_MCOUNTEREN, (ulong)&trap);
+		break;
+	default:
+		break;
+	}
+
+	return !trap.cause;
+}
+#else
+static bool hart_features_verify(const struct sbi_hart_features *hfeatures)
+{
+	return true;
+}
+#endif
+
+static bool hart_features_share_get(struct sbi_hart_features *hfeatures)
+{
+	struct hart_features_class *fc;
+	bool found = false;
+
+	spin_lock(&hart_features_classes_lock);
+	fc = hart_features_class_find(false);
+	if (fc && fc->valid) {
+		*hfeatures = fc->features;
+		found = true;
+	}
+	spin_unlock(&hart_features_classes_lock);
+
+	if (found && !hart_features_verify(hfeatures)) {
+		sbi_printf("%s: hart%u features differ from marchid 0x%lx, "
+			   "probing\n", __func__, current_hartid(),
+			   csr_read(CSR_MARCHID));
+		found = false;
+	}
+
+	return found;
+}
+
+static void hart_features_share_put(const struct sbi_hart_features *hfeatures)
+{
+	struct hart_features_class *fc;
+
+	spin_lock(&hart_features_classes_lock);
+	fc = hart_features_class_find(true);
+	if (fc && !fc->valid) {
+		fc->features = *hfeatures;
+		fc->valid = true;
+	}
+	spin_unlock(&hart_features_classes_lock);
+}
+
+#else
+
+static bool hart_features_share_get(struct sbi_hart_features *hfeatures)
+{
+	return false;
+}
+
+static void hart_features_share_put(const struct sbi_hart_features *hfeatures)
+{
+}
+
+#endif
+
+static int hart_detect_features(struct sbi_scratch *scratch)
+{
+	struct sbi_hart_features *hfeatures =
+		sbi_scratch_offset_ptr(scratch, hart_features_offset);
+	bool has_zicntr = false;
+	int rc;
+
+	/* If hart features already detected then do nothing */
+	if (hfeatures->detected)
+		return 0;
+
+	/* Probe with traps unless an identical HART already did */
+	if (!hart_features_share_get(hfeatures)) {
+		hart_probe_features(hfeatures);
+		hart_features_share_put(hfeatures);
+	}
+
 	/* Save trap based detection of Zicntr */
 	has_zicntr = sbi_hart_has_extension(scratch, SBI_HART_EXT_ZICNTR);
 
@@ -939,6 +1643,106 @@ __pmp_skip:
 	return 0;
 }
 
+void sbi_hart_resume_save(struct sbi_scratch *scratch)
+{
+	struct hart_resume_state *rs;
+	int priv = sbi_hart_priv_version(scratch);
+
+	if (!hart_resume_state_offset)
+		return;
+	rs = sbi_scratch_offset_ptr(scratch, hart_resume_state_offset);
+
+	rs->dom = sbi_domain_thishart_ptr();
+	rs->has_smode = misa_extension('S');
+	rs->has_mcounteren = priv >= SBI_HART_PRIV_VER_1_10;
+	rs->has_mcountinhibit = priv >= SBI_HART_PRIV_VER_1_11;
+	rs->has_menvcfg = priv >= SBI_HART_PRIV_VER_1_12;
+	/* Seed access bits are only set up when Zkr is present */
+	rs->has_mseccfg = rs->has_menvcfg &&
+			  sbi_hart_has_extension(scratch, SBI_HART_EXT_ZKR);
+	rs->has_mstateen = sbi_hart_has_extension(scratch,
+						  SBI_HART_EXT_SMSTATEEN);
+
+	rs->mstatus = csr_read(CSR_MSTATUS);
+	rs->mtvec = csr_read(CSR_MTVEC);
+	if (rs->has_smode) {
+		rs->medeleg = csr_read(CSR_MEDELEG);
+		rs->mideleg = csr_read(CSR_MIDELEG);
+		if (rs->has_mcounteren)
+			rs->scounteren = csr_read(CSR_SCOUNTEREN);
+	}
+	if (rs->has_mcounteren)
+		rs->mcounteren = csr_read(CSR_MCOUNTEREN);
+	if (rs->has_mcountinhibit)
+		rs->mcountinhibit = csr_read(CSR_MCOUNTINHIBIT);
+	if (rs->has_menvcfg) {
+		rs->menvcfg = csr_read(CSR_MENVCFG);
+#if __riscv_xlen == 32
+		rs->menvcfgh = csr_read(CSR_MENVCFGH);
+#endif
+	}
+	if (rs->has_mseccfg)
+		rs->mseccfg_seed = csr_read(CSR_MSECCFG) &
+				   (MSECCFG_SSEED | MSECCFG_USEED);
+	if (rs->has_mstateen) {
+		rs->mstateen0 = csr_read(CSR_MSTATEEN0);
+#if __riscv_xlen == 32
+		rs->mstateen0h = csr_read(CSR_MSTATEEN0H);
+#endif
+	}
+
+	rs->valid = true;
+}
+
+int sbi_hart_resume_restore(struct sbi_scratch *scratch)
+{
+	struct hart_resume_state *rs;
+
+	if (!hart_resume_state_offset)
+		return SBI_ENOENT;
+	rs = sbi_scratch_offset_ptr(scratch, hart_resume_state_offset);
+
+	/* Full init is needed if the hart changed domain or features */
+	if (!rs->valid || rs->dom != sbi_domain_thishart_ptr())
+		return SBI_ENOENT;
+
+	csr_write(CSR_MSTATUS, rs->mstatus);
+	csr_write(CSR_MTVEC, rs->mtvec);
+	if (rs->has_smode) {
+		csr_write(CSR_MIDELEG, rs->mideleg);
+		csr_write(CSR_MEDELEG, rs->medeleg);
+		if (rs->has_mcounteren)
+			csr_write(CSR_SCOUNTEREN, rs->scounteren);
+		csr_write(CSR_SATP, 0);
+	}
+	if (rs->has_mcounteren)
+		csr_write(CSR_MCOUNTEREN, rs->mcounteren);
+	if (rs->has_mcountinhibit)
+		csr_write(CSR_MCOUNTINHIBIT, rs->mcountinhibit);
+	if (rs->has_menvcfg) {
+		csr_write(CSR_MENVCFG, rs->menvcfg);
+#if __riscv_xlen == 32
+		csr_write(CSR_MENVCFGH, rs->menvcfgh);
+#endif
+	}
+	if (rs->has_mseccfg) {
+		csr_set(CSR_MSECCFG, rs->mseccfg_seed);
+		csr_clear(CSR_MSECCFG,
+			  ~rs->mseccfg_seed & (MSECCFG_SSEED | MSECCFG_USEED));
+	}
+	if (rs->has_mstateen) {
+		csr_write(CSR_MSTATEEN0, rs->mstateen0);
+#if __riscv_xlen == 32
+		csr_write(CSR_MSTATEEN0H, rs->mstateen0h);
+#endif
+	}
+	csr_write(CSR_MIE, 0);
+
+	mhpmevent_init(scratch);
+
+	return sbi_hart_pmp_configure(scratch);
+}
+
 int sbi_hart_reinit(struct sbi_scratch *scratch)
 {
 	int rc;
@@ -974,6 +1778,16 @@ int sbi_hart_init(struct sbi_scratch *scratch, bool cold_boot)
 					sizeof(struct sbi_hart_features));
 		if (!hart_features_offset)
 			return SBI_ENOMEM;
+
+		hart_saddr_window_offset = sbi_scratch_alloc_offset(
+					sizeof(struct hart_saddr_window));
+		if (!hart_saddr_window_offset)
+			return SBI_ENOMEM;
+
+		hart_resume_state_offset = sbi_scratch_alloc_offset(
+					sizeof(struct hart_resume_state));
+		if (!hart_resume_state_offset)
+			return SBI_ENOMEM;
 	}
 
 	rc = hart_detect_features(scratch);
@@ -19,6 +19,8 @@
 #include <sbi/sbi_hart.h>
 #include <sbi/sbi_hartmask.h>
 #include <sbi/sbi_hsm.h>
+#include <sbi/sbi_hsm_stats.h>
+#include <sbi/sbi_idle.h>
 #include <sbi/sbi_init.h>
 #include <sbi/sbi_ipi.h>
 #include <sbi/sbi_scratch.h>
@@ -160,6 +162,7 @@ void __noreturn sbi_hsm_hart_start_finish(struct sbi_scratch *scratch,
 static void sbi_hsm_hart_wait(struct sbi_scratch *scratch, u32 hartid)
 {
 	unsigned long saved_mie;
+	long state;
 	struct sbi_hsm_data *hdata = sbi_scratch_offset_ptr(scratch,
 							    hart_data_offset);
 	/* Save MIE CSR */
@@ -169,8 +172,12 @@ static void sbi_hsm_hart_wait(struct sbi_scratch *scratch, u32 hartid)
 	csr_set(CSR_MIE, MIP_MSIP | MIP_MEIP);
 
 	/* Wait for state transition requested by sbi_hsm_hart_start() */
-	while (atomic_read(&hdata->state) != SBI_HSM_STATE_START_PENDING) {
-		wfi();
+	while ((state = atomic_read(&hdata->state)) !=
+	       SBI_HSM_STATE_START_PENDING) {
+		if (!sbi_hart_wait_on_ulong((volatile unsigned long *)
+					    &hdata->state.counter,
+					    state, false))
+			wfi();
 	}
 
 	/* Restore MIE CSR */
@@ -238,6 +245,7 @@ static void hsm_device_hart_resume(void)
 
 int sbi_hsm_init(struct sbi_scratch *scratch, u32 hartid, bool cold_boot)
 {
+	int rc;
 	u32 i;
 	struct sbi_scratch *rscratch;
 	struct sbi_hsm_data *hdata;
@@ -261,6 +269,14 @@ int sbi_hsm_init(struct sbi_scratch *scratch, u32 hartid, bool cold_boot)
 				    SBI_HSM_STATE_STOPPED);
 			ATOMIC_INIT(&hdata->start_ticket, 0);
 		}
+
+		rc = sbi_idle_init(scratch, cold_boot);
+		if (rc)
+			return rc;
+
+		rc = sbi_hsm_stats_init(scratch, cold_boot);
+		if (rc)
+			return rc;
 	} else {
 		sbi_hsm_hart_wait(scratch, hartid);
 	}
@@ -296,14 +312,105 @@ fail_exit:
 	sbi_hart_hang();
 }
 
+static struct sbi_hsm_data *hsm_hart_data(u32 hartid)
+{
+	struct sbi_scratch *rscratch = sbi_hartid_to_scratch(hartid);
+
+	if (!rscratch)
+		return NULL;
+	return sbi_scratch_offset_ptr(rscratch, hart_data_offset);
+}
+
+/*
+ * Move a stopped hart to START_PENDING with the given next stage.
+ * The caller must hold the start ticket of the hart, which stays
+ * acquired in all cases. On success, the caller must wake up the hart
+ * (or release the ticket on failure). The use_device output tells
+ * whether the hart must be started through the HSM device instead of
+ * an IPI.
+ */
+static int __hsm_hart_start_claim(u32 hartid, struct sbi_hsm_data *hdata,
+				  ulong saddr, ulong smode, ulong arg1,
+				  bool *use_device)
+{
+	unsigned long init_count, entry_count;
+	unsigned int hstate;
+	struct sbi_scratch *rscratch = sbi_hartid_to_scratch(hartid);
+
+	init_count = sbi_init_count(hartid);
+	entry_count = sbi_entry_count(hartid);
+
+	rscratch->next_arg1 = arg1;
+	rscratch->next_addr = saddr;
+	rscratch->next_mode = smode;
+
+	/*
+	 * atomic_cmpxchg() is an implicit barrier. It makes sure that
+	 * other harts see reading of init_count and writing to *rscratch
+	 * before hdata->state is set to SBI_HSM_STATE_START_PENDING.
+	 */
+	hstate = atomic_cmpxchg(&hdata->state, SBI_HSM_STATE_STOPPED,
+				SBI_HSM_STATE_START_PENDING);
+	if (hstate != SBI_HSM_STATE_STOPPED) {
+		/**
+		 * if a hart is already transition to start or stop, another
+		 * start call is considered as invalid request.
+		 */
+		return (hstate == SBI_HSM_STATE_STARTED) ?
+			SBI_EALREADY : SBI_EINVAL;
+	}
+
+	*use_device =
+		(hsm_device_has_hart_hotplug() && (entry_count == init_count)) ||
+		(hsm_device_has_hart_secondary_boot() && !init_count);
+
+	return 0;
+}
+
+/*
+ * Acquire the start ticket of a hart and move it to START_PENDING.
+ * On success, the start ticket of the hart stays acquired and the
+ * caller must wake up the hart (or release the ticket on failure).
+ */
+static int hsm_hart_start_claim(u32 hartid, ulong saddr, ulong smode,
+				ulong arg1, struct sbi_hsm_data **out_hdata,
+				bool *use_device)
+{
+	struct sbi_hsm_data *hdata;
+	int rc;
+
+	hdata = hsm_hart_data(hartid);
+	if (!hdata)
+		return SBI_EINVAL;
+	if (!hsm_start_ticket_acquire(hdata))
+		return SBI_EINVAL;
+
+	rc = __hsm_hart_start_claim(hartid, hdata, saddr, smode, arg1,
+				    use_device);
+	if (rc) {
+		hsm_start_ticket_release(hdata);
+		return rc;
+	}
+
+	*out_hdata = hdata;
+	return 0;
+}
+
+static void hsm_start_tickets_release(const struct sbi_hartmask *mask)
+{
+	u32 i;
+
+	sbi_hartmask_for_each_hartindex(i, mask)
+		hsm_start_ticket_release(hsm_hart_data(
+					sbi_hartindex_to_hartid(i)));
+}
+
 int sbi_hsm_hart_start(struct sbi_scratch *scratch,
 		       const struct sbi_domain *dom,
 		       u32 hartid, ulong saddr, ulong smode, ulong arg1)
 {
-	unsigned long init_count, entry_count;
-	unsigned int hstate;
-	struct sbi_scratch *rscratch;
 	struct sbi_hsm_data *hdata;
+	bool use_device;
 	int rc;
 
 	/* For now, we only allow start mode to be S-mode or U-mode. */
@@ -315,54 +422,121 @@ int sbi_hsm_hart_start(struct sbi_scratch *scratch,
 					  SBI_DOMAIN_EXECUTE))
 		return SBI_EINVALID_ADDR;
 
-	rscratch = sbi_hartid_to_scratch(hartid);
-	if (!rscratch)
-		return SBI_EINVAL;
+	rc = hsm_hart_start_claim(hartid, saddr, smode, arg1,
+				  &hdata, &use_device);
+	if (rc)
+		return rc;
 
-	hdata = sbi_scratch_offset_ptr(rscratch, hart_data_offset);
-	if (!hsm_start_ticket_acquire(hdata))
-		return SBI_EINVAL;
+	if (use_device)
+		rc = hsm_device_hart_start(hartid, scratch->warmboot_addr);
+	else
+		rc = sbi_ipi_raw_send(sbi_hartid_to_hartindex(hartid));
 
-	init_count = sbi_init_count(hartid);
-	entry_count = sbi_entry_count(hartid);
+	if (rc)
+		hsm_start_ticket_release(hdata);
+	return rc;
+}
 
-	rscratch->next_arg1 = arg1;
-	rscratch->next_addr = saddr;
-	rscratch->next_mode = smode;
+/*
+ * Start a set of harts with the same next stage. All targets are
+ * validated and claimed first, so an invalid, busy or already started
+ * target fails the call without starting any hart. Only a failure of
+ * the HSM device or of the IPI, after the claims, can leave some of the
+ * targets started; their state can be read with the HSM status call.
+ */
+int sbi_hsm_hart_start_many(struct sbi_scratch *scratch,
+			    const struct sbi_domain *dom,
+			    ulong hmask, ulong hbase,
+			    ulong saddr, ulong smode, ulong arg1)
+{
+	struct sbi_hartmask target_mask = {0}, claim_mask = {0};
+	struct sbi_hartmask ipi_mask = {0};
+	struct sbi_hsm_data *hdata;
+	bool use_device, all_harts = false;
+	int rc, hstate, ret = 0;
+	ulong i, m;
+	u32 hartid;
 
-	/*
-	 * atomic_cmpxchg() is an implicit barrier. It makes sure that
-	 * other harts see reading of init_count and writing to *rscratch
-	 * before hdata->state is set to SBI_HSM_STATE_START_PENDING.
-	 */
-	hstate = atomic_cmpxchg(&hdata->state, SBI_HSM_STATE_STOPPED,
-				SBI_HSM_STATE_START_PENDING);
-	if (hstate == SBI_HSM_STATE_STARTED) {
-		rc = SBI_EALREADY;
-		goto err;
+	/* Validate all targets once before changing any state */
+	if (smode != PRV_S && smode != PRV_U)
+		return SBI_EINVAL;
+	if (dom && !sbi_domain_check_addr(dom, saddr, smode,
+					  SBI_DOMAIN_EXECUTE))
+		return SBI_EINVALID_ADDR;
+
+	if (hbase != -1UL) {
+		if (!sbi_hartid_valid(hbase))
+			return SBI_EINVAL;
+		for (i = hbase, m = hmask; m; i++, m >>= 1) {
+			if (!(m & 1UL))
+				continue;
+			if (!sbi_hartid_valid(i) ||
+			    (dom && !sbi_domain_is_assigned_hart(dom, i)))
+				return SBI_EINVAL;
+			sbi_hartmask_set_hartid(i, &target_mask);
+		}
+	} else {
+		if (!dom)
+			return SBI_EINVAL;
+		all_harts = true;
+		sbi_hartmask_for_each_hartindex(i, &dom->assigned_harts)
+			sbi_hartmask_set_hartindex(i, &target_mask);
+		/* Skip the calling hart which is obviously started */
+		sbi_hartmask_clear_hartid(current_hartid(), &target_mask);
 	}
 
-	/**
-	 * if a hart is already transition to start or stop, another start call
-	 * is considered as invalid request.
+	/*
+	 * Claim the start ticket of every target before starting any of
+	 * them. A stopped hart can only leave STOPPED through a start call
+	 * holding its ticket, so all claimed harts are still stopped below.
 	 */
-	if (hstate != SBI_HSM_STATE_STOPPED) {
+	sbi_hartmask_for_each_hartindex(i, &target_mask) {
+		hdata = hsm_hart_data(sbi_hartindex_to_hartid(i));
 		rc = SBI_EINVAL;
-		goto err;
+		if (hdata && hsm_start_ticket_acquire(hdata)) {
+			hstate = atomic_read(&hdata->state);
+			if (hstate == SBI_HSM_STATE_STOPPED) {
+				sbi_hartmask_set_hartindex(i, &claim_mask);
+				continue;
+			}
+			hsm_start_ticket_release(hdata);
+			rc = (hstate == SBI_HSM_STATE_STARTED) ?
+				SBI_EALREADY : SBI_EINVAL;
+		}
+		/* Harts already running are not an error for "all harts" */
+		if (rc == SBI_EALREADY && all_harts)
+			continue;
+		hsm_start_tickets_release(&claim_mask);
+		return rc;
 	}
 
-	if ((hsm_device_has_hart_hotplug() && (entry_count == init_count)) ||
-	   (hsm_device_has_hart_secondary_boot() && !init_count)) {
-		rc = hsm_device_hart_start(hartid, scratch->warmboot_addr);
-	} else {
-		rc = sbi_ipi_raw_send(sbi_hartid_to_hartindex(hartid));
+	/* Transition all claimed harts, hotplugged harts go via HSM device */
+	sbi_hartmask_for_each_hartindex(i, &claim_mask) {
+		hartid = sbi_hartindex_to_hartid(i);
+		hdata = hsm_hart_data(hartid);
+		rc = __hsm_hart_start_claim(hartid, hdata, saddr, smode, arg1,
+					    &use_device);
+		if (!rc && use_device)
+			rc = hsm_device_hart_start(hartid,
+						   scratch->warmboot_addr);
+		else if (!rc)
+			sbi_hartmask_set_hartindex(i, &ipi_mask);
+		if (rc) {
+			hsm_start_ticket_release(hdata);
+			if (!ret)
+				ret = rc;
+		}
 	}
 
-	if (!rc)
-		return 0;
-err:
-	hsm_start_ticket_release(hdata);
-	return rc;
+	/* Wake up the remaining targets with one batch of IPIs */
+	rc = sbi_ipi_raw_send_many(&ipi_mask);
+	if (rc) {
+		hsm_start_tickets_release(&ipi_mask);
+		if (!ret)
+			ret = rc;
+	}
+
+	return ret;
 }
 
 int sbi_hsm_hart_stop(struct sbi_scratch *scratch, bool exitnow)
@@ -378,6 +552,9 @@ int sbi_hsm_hart_stop(struct sbi_scratch *scratch, bool exitnow)
 					 SBI_HSM_STATE_STOP_PENDING))
 		return SBI_EFAIL;
 
+	/* A HART is started again by the domain it is assigned to */
+	sbi_domain_reset_hart(sbi_hartid_to_hartindex(current_hartid()));
+
 	if (exitnow)
 		sbi_exit(scratch);
 
@@ -434,6 +611,8 @@ void sbi_hsm_hart_resume_start(struct sbi_scratch *scratch)
 					 SBI_HSM_STATE_RESUME_PENDING))
 		sbi_hart_hang();
 
+	sbi_hsm_stats_resume_start(scratch);
+	sbi_idle_exit(scratch);
 	hsm_device_hart_resume();
 }
 
@@ -454,15 +633,36 @@ void __noreturn sbi_hsm_hart_resume_finish(struct sbi_scratch *scratch,
 	 */
 	__sbi_hsm_suspend_non_ret_restore(scratch);
 
+	sbi_hsm_stats_resume_finish(scratch);
+
 	sbi_hart_switch_mode(hartid, scratch->next_arg1,
 			     scratch->next_addr,
 			     scratch->next_mode, false);
 }
 
+static int hsm_hart_suspend_enter(struct sbi_scratch *scratch,
+				  u32 suspend_type)
+{
+	int ret;
+
+	/* Try platform specific suspend */
+	ret = hsm_device_hart_suspend(suspend_type);
+	if (ret == SBI_ENOTSUPP) {
+		/* Try generic implementation of default suspend types */
+		if (suspend_type == SBI_HSM_SUSPEND_RET_DEFAULT ||
+		    suspend_type == SBI_HSM_SUSPEND_NON_RET_DEFAULT) {
+			ret = __sbi_hsm_suspend_default(scratch);
+		}
+	}
+
+	return ret;
+}
+
 int sbi_hsm_hart_suspend(struct sbi_scratch *scratch, u32 suspend_type,
 			 ulong raddr, ulong rmode, ulong arg1)
 {
 	int ret;
+	u32 enter_type;
 	const struct sbi_domain *dom = sbi_domain_thishart_ptr();
 	struct sbi_hsm_data *hdata = sbi_scratch_offset_ptr(scratch,
 							    hart_data_offset);
@@ -512,14 +712,26 @@ int sbi_hsm_hart_suspend(struct sbi_scratch *scratch, u32 suspend_type,
 	if (suspend_type & SBI_HSM_SUSP_NON_RET_BIT)
 		__sbi_hsm_suspend_non_ret_save(scratch);
 
-	/* Try platform specific suspend */
-	ret = hsm_device_hart_suspend(suspend_type);
-	if (ret == SBI_ENOTSUPP) {
-		/* Try generic implementation of default suspend types */
-		if (suspend_type == SBI_HSM_SUSPEND_RET_DEFAULT ||
-		    suspend_type == SBI_HSM_SUSPEND_NON_RET_DEFAULT) {
-			ret = __sbi_hsm_suspend_default(scratch);
-		}
+	/*
+	 * Let the idle governor pick the state actually entered. The
+	 * requested suspend type still decides how we resume so a
+	 * non-retentive request entered as retentive state returns
+	 * through the warm boot path below.
+	 */
+	enter_type = sbi_idle_select(scratch, suspend_type);
+	sbi_hsm_stats_suspend_enter(scratch, enter_type);
+
+	ret = hsm_hart_suspend_enter(scratch, enter_type);
+
+	/*
+	 * The state picked by the governor may be refused by the platform,
+	 * so fall back to the suspend type S-mode asked for.
+	 */
+	if (ret && enter_type != suspend_type) {
+		sbi_hsm_stats_suspend_abort(scratch);
+		sbi_idle_fallback(scratch);
+		sbi_hsm_stats_suspend_enter(scratch, suspend_type);
+		ret = hsm_hart_suspend_enter(scratch, suspend_type);
 	}
 
 	/*
@@ -539,9 +751,15 @@ int sbi_hsm_hart_suspend(struct sbi_scratch *scratch, u32 suspend_type,
 	 * We might have successfully resumed from retentive suspend
 	 * or suspend failed. In both cases, we restore state of hart.
 	 */
+	if (ret)
+		sbi_hsm_stats_suspend_abort(scratch);
+	else
+		sbi_hsm_stats_resume_start(scratch);
+	sbi_idle_exit(scratch);
 	if (!__sbi_hsm_hart_change_state(hdata, SBI_HSM_STATE_SUSPENDED,
 					 SBI_HSM_STATE_STARTED))
 		sbi_hart_hang();
+	sbi_hsm_stats_resume_finish(scratch);
 
 	return ret;
 }
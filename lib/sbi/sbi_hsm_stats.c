@@ -0,0 +1,224 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Copyright (c) 2026 OpenSBI contributors.
+ */
+
+#include <sbi/sbi_console.h>
+#include <sbi/sbi_domain.h>
+#include <sbi/sbi_error.h>
+#include <sbi/sbi_hsm_stats.h>
+#include <sbi/sbi_idle.h>
+#include <sbi/sbi_pmu.h>
+#include <sbi/sbi_scratch.h>
+#include <sbi/sbi_timer.h>
+
+/* Per-HART suspend statistics */
+struct hsm_stats_hart {
+	/* Slot of the suspend in progress or -1 */
+	int current;
+	/* Timer values at suspend entry and resume start */
+	u64 enter_time;
+	u64 resume_time;
+	/* Timer event pending at suspend entry */
+	u64 next_event;
+	/* Suspend types which did not fit in types[] */
+	u64 dropped;
+	u32 count;
+	struct sbi_hsm_suspend_stats types[SBI_HSM_STATS_MAX_TYPES];
+};
+
+static unsigned long hsm_stats_offset;
+
+static struct hsm_stats_hart *hsm_stats_ptr(struct sbi_scratch *scratch)
+{
+	if (!scratch || !hsm_stats_offset)
+		return NULL;
+
+	return sbi_scratch_offset_ptr(scratch, hsm_stats_offset);
+}
+
+static int hsm_stats_slot(struct hsm_stats_hart *hs, u32 suspend_type,
+			  bool alloc)
+{
+	struct sbi_hsm_suspend_stats *st;
+	u32 i;
+
+	for (i = 0; i < hs->count; i++) {
+		if (hs->types[i].suspend_type == suspend_type)
+			return i;
+	}
+
+	if (!alloc || hs->count >= SBI_HSM_STATS_MAX_TYPES)
+		return -1;
+
+	st = &hs->types[hs->count];
+	st->suspend_type = suspend_type;
+	st->exit_latency_min = -1ULL;
+
+	return hs->count++;
+}
+
+void sbi_hsm_stats_suspend_enter(struct sbi_scratch *scratch,
+				 u32 suspend_type)
+{
+	struct hsm_stats_hart *hs = hsm_stats_ptr(scratch);
+
+	if (!hs)
+		return;
+
+	hs->current = hsm_stats_slot(hs, suspend_type, true);
+	if (hs->current < 0) {
+		hs->dropped++;
+		return;
+	}
+
+	hs->next_event = sbi_timer_next_event();
+	hs->enter_time = sbi_timer_value();
+}
+
+void sbi_hsm_stats_suspend_abort(struct sbi_scratch *scratch)
+{
+	struct hsm_stats_hart *hs = hsm_stats_ptr(scratch);
+
+	if (hs)
+		hs->current = -1;
+}
+
+void sbi_hsm_stats_resume_start(struct sbi_scratch *scratch)
+{
+	struct hsm_stats_hart *hs = hsm_stats_ptr(scratch);
+	struct sbi_hsm_suspend_stats *st;
+	u64 residency;
+
+	if (!hs || hs->current < 0)
+		return;
+	st = &hs->types[hs->current];
+
+	hs->resume_time = sbi_timer_value();
+	residency = hs->resume_time - hs->enter_time;
+
+	st->entries++;
+	st->residency += residency;
+	sbi_pmu_ctr_add_fw(SBI_PMU_FW_HSM_SUSPEND, 1);
+	sbi_pmu_ctr_add_fw(SBI_PMU_FW_RES_SUSPEND, residency);
+
+	/* Woken up by something other than the timer S-mode programmed */
+	if (hs->resume_time < hs->next_event) {
+		st->early_wakes++;
+		sbi_pmu_ctr_add_fw(SBI_PMU_FW_HSM_EARLY_WAKE, 1);
+	}
+}
+
+void sbi_hsm_stats_resume_finish(struct sbi_scratch *scratch)
+{
+	struct hsm_stats_hart *hs = hsm_stats_ptr(scratch);
+	struct sbi_hsm_suspend_stats *st;
+	u64 latency;
+
+	if (!hs || hs->current < 0)
+		return;
+	st = &hs->types[hs->current];
+	hs->current = -1;
+
+	latency = sbi_timer_value() - hs->resume_time;
+	st->exits++;
+	st->exit_latency += latency;
+	if (latency < st->exit_latency_min)
+		st->exit_latency_min = latency;
+	if (latency > st->exit_latency_max)
+		st->exit_latency_max = latency;
+	sbi_pmu_ctr_add_fw(SBI_PMU_FW_RES_RESUME, latency);
+}
+
+const struct sbi_hsm_suspend_stats *sbi_hsm_stats_get(u32 hartindex,
+						      u32 suspend_type)
+{
+	struct hsm_stats_hart *hs;
+	int slot;
+
+	hs = hsm_stats_ptr(sbi_hartindex_to_scratch(hartindex));
+	if (!hs)
+		return NULL;
+
+	slot = hsm_stats_slot(hs, suspend_type, false);
+	if (slot < 0)
+		return NULL;
+
+	return &hs->types[slot];
+}
+
+int sbi_hsm_stats_dump(const struct sbi_domain *dom)
+{
+	const struct sbi_hsm_suspend_stats *st;
+	const struct sbi_idle_stats *is;
+	struct sbi_scratch *scratch;
+	struct hsm_stats_hart *hs;
+	u64 lat_min, lat_avg;
+	u32 i, j;
+
+	if (!dom)
+		return SBI_EINVAL;
+
+	sbi_printf("HSM suspend statistics (timer ticks):\n");
+	sbi_printf("%-6s %-10s %10s %12s %8s %8s %8s %8s\n",
+		   "HART", "Type", "Entries", "Residency", "Early",
+		   "LatMin", "LatAvg", "LatMax");
+
+	sbi_hartmask_for_each_hartindex(i, &dom->assigned_harts) {
+		scratch = sbi_hartindex_to_scratch(i);
+		hs = hsm_stats_ptr(scratch);
+		if (!hs)
+			continue;
+
+		for (j = 0; j < hs->count; j++) {
+			st = &hs->types[j];
+			lat_min = st->exits ? st->exit_latency_min : 0;
+			lat_avg = st->exits ? st->exit_latency / st->exits : 0;
+			sbi_printf("%-6u 0x%08x %10llu %12llu %8llu "
+				   "%8llu %8llu %8llu\n",
+				   sbi_hartindex_to_hartid(i), st->suspend_type,
+				   (unsigned long long)st->entries,
+				   (unsigned long long)st->residency,
+				   (unsigned long long)st->early_wakes,
+				   (unsigned long long)lat_min,
+				   (unsigned long long)lat_avg,
+				   (unsigned long long)st->exit_latency_max);
+		}
+		if (hs->dropped)
+			sbi_printf("%-6u %llu suspends of untracked types\n",
+				   sbi_hartindex_to_hartid(i),
+				   (unsigned long long)hs->dropped);
+
+		/* Idle governor choices which the wakeup proved wrong */
+		is = sbi_idle_get_stats(scratch);
+		if (is && (is->demoted || is->promoted || is->too_deep))
+			sbi_printf("%-6u idle demoted %lu promoted %lu "
+				   "too deep %lu too shallow %lu\n",
+				   sbi_hartindex_to_hartid(i), is->demoted,
+				   is->promoted, is->too_deep, is->too_shallow);
+	}
+
+	return 0;
+}
+
+int sbi_hsm_stats_init(struct sbi_scratch *scratch, bool cold_boot)
+{
+	struct hsm_stats_hart *hs;
+	u32 i;
+
+	if (!cold_boot)
+		return 0;
+
+	hsm_stats_offset = sbi_scratch_alloc_offset(sizeof(*hs));
+	if (!hsm_stats_offset)
+		return SBI_ENOMEM;
+
+	for (i = 0; i <= sbi_scratch_last_hartindex(); i++) {
+		hs = hsm_stats_ptr(sbi_hartindex_to_scratch(i));
+		if (hs)
+			hs->current = -1;
+	}
+
+	return 0;
+}
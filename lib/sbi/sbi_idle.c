@@ -0,0 +1,186 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Copyright (c) 2026 OpenSBI contributors.
+ */
+
+#include <sbi/sbi_ecall_interface.h>
+#include <sbi/sbi_error.h>
+#include <sbi/sbi_idle.h>
+#include <sbi/sbi_scratch.h>
+#include <sbi/sbi_string.h>
+#include <sbi/sbi_timer.h>
+
+/* Per-HART idle governor state */
+struct idle_hart_data {
+	/* An idle period selected by the governor is in progress */
+	bool active;
+	/* Index of the requested and the entered state */
+	int req_idx;
+	int enter_idx;
+	/* Timer value when the idle period started */
+	u64 start;
+	struct sbi_idle_stats stats;
+};
+
+static struct sbi_idle_state idle_states[SBI_IDLE_MAX_STATES];
+static u32 idle_state_count;
+static unsigned long idle_hart_offset;
+
+int sbi_idle_state_register(const struct sbi_idle_state *state)
+{
+	u32 i;
+
+	if (!state)
+		return SBI_EINVAL;
+
+	for (i = 0; i < idle_state_count; i++) {
+		if (idle_states[i].suspend_type == state->suspend_type)
+			return SBI_EALREADY;
+	}
+	if (idle_state_count >= SBI_IDLE_MAX_STATES)
+		return SBI_ENOSPC;
+
+	idle_states[idle_state_count++] = *state;
+
+	return 0;
+}
+
+static int idle_state_find(u32 suspend_type)
+{
+	u32 i;
+
+	for (i = 0; i < idle_state_count; i++) {
+		if (idle_states[i].suspend_type == suspend_type)
+			return i;
+	}
+
+	return -1;
+}
+
+static u64 idle_ticks_to_us(u64 ticks)
+{
+	const struct sbi_timer_device *tdev = sbi_timer_get_device();
+
+	if (!tdev || !tdev->timer_freq)
+		return -1ULL;
+
+	return (ticks / tdev->timer_freq) * 1000000ULL +
+	       ((ticks % tdev->timer_freq) * 1000000ULL) / tdev->timer_freq;
+}
+
+u32 sbi_idle_select(struct sbi_scratch *scratch, u32 suspend_type)
+{
+	struct idle_hart_data *ihd;
+	const struct sbi_idle_state *req, *st;
+	u64 now, next, predicted_us;
+	int i, req_idx, best = -1;
+
+	if (!idle_hart_offset)
+		return suspend_type;
+	ihd = sbi_scratch_offset_ptr(scratch, idle_hart_offset);
+	ihd->active = false;
+
+	req_idx = idle_state_find(suspend_type);
+	if (req_idx < 0)
+		return suspend_type;
+	req = &idle_states[req_idx];
+
+	now = sbi_timer_value();
+	next = sbi_timer_next_event();
+	predicted_us = (next == -1ULL) ? -1ULL :
+		       (next <= now) ? 0 : idle_ticks_to_us(next - now);
+
+	/*
+	 * Pick the deepest state worth entering before the next timer
+	 * event which does not exceed the exit latency S-mode accepted
+	 * and which keeps the context if S-mode asked for retention.
+	 */
+	for (i = 0; i < idle_state_count; i++) {
+		st = &idle_states[i];
+		if (!(req->suspend_type & SBI_HSM_SUSP_NON_RET_BIT) &&
+		    (st->suspend_type & SBI_HSM_SUSP_NON_RET_BIT))
+			continue;
+		if (st->exit_latency_us > req->exit_latency_us ||
+		    st->min_residency_us > predicted_us)
+			continue;
+		if (best < 0 ||
+		    st->min_residency_us > idle_states[best].min_residency_us)
+			best = i;
+	}
+
+	/* Fallback to shallowest allowed state if nothing fits */
+	if (best < 0)
+		best = req_idx;
+
+	if (idle_states[best].min_residency_us < req->min_residency_us)
+		ihd->stats.demoted++;
+	else if (idle_states[best].min_residency_us > req->min_residency_us)
+		ihd->stats.promoted++;
+
+	ihd->req_idx = req_idx;
+	ihd->enter_idx = best;
+	ihd->start = now;
+	ihd->active = true;
+
+	return idle_states[best].suspend_type;
+}
+
+void sbi_idle_fallback(struct sbi_scratch *scratch)
+{
+	struct idle_hart_data *ihd;
+
+	if (!idle_hart_offset)
+		return;
+	ihd = sbi_scratch_offset_ptr(scratch, idle_hart_offset);
+	if (!ihd->active)
+		return;
+
+	ihd->enter_idx = ihd->req_idx;
+	ihd->start = sbi_timer_value();
+}
+
+void sbi_idle_exit(struct sbi_scratch *scratch)
+{
+	struct idle_hart_data *ihd;
+	u64 slept_us;
+
+	if (!idle_hart_offset)
+		return;
+	ihd = sbi_scratch_offset_ptr(scratch, idle_hart_offset);
+	if (!ihd->active)
+		return;
+	ihd->active = false;
+
+	slept_us = idle_ticks_to_us(sbi_timer_value() - ihd->start);
+	if (slept_us < idle_states[ihd->enter_idx].min_residency_us)
+		ihd->stats.too_deep++;
+	else if (ihd->enter_idx != ihd->req_idx &&
+		 idle_states[ihd->req_idx].min_residency_us <= slept_us &&
+		 idle_states[ihd->enter_idx].min_residency_us <
+		 idle_states[ihd->req_idx].min_residency_us)
+		ihd->stats.too_shallow++;
+}
+
+const struct sbi_idle_stats *sbi_idle_get_stats(struct sbi_scratch *scratch)
+{
+	struct idle_hart_data *ihd;
+
+	if (!idle_hart_offset)
+		return NULL;
+	ihd = sbi_scratch_offset_ptr(scratch, idle_hart_offset);
+
+	return &ihd->stats;
+}
+
+int sbi_idle_init(struct sbi_scratch *scratch, bool cold_boot)
+{
+	if (cold_boot) {
+		idle_hart_offset = sbi_scratch_alloc_offset(
+					sizeof(struct idle_hart_data));
+		if (!idle_hart_offset)
+			return SBI_ENOMEM;
+	}
+
+	return 0;
+}
@@ -11,9 +11,11 @@
 #include <sbi/riscv_atomic.h>
 #include <sbi/riscv_barrier.h>
 #include <sbi/riscv_locks.h>
+#include <sbi/sbi_boot_prof.h>
 #include <sbi/sbi_console.h>
 #include <sbi/sbi_cppc.h>
 #include <sbi/sbi_domain.h>
+#include <sbi/sbi_domain_context.h>
 #include <sbi/sbi_ecall.h>
 #include <sbi/sbi_hart.h>
 #include <sbi/sbi_hartmask.h>
@@ -28,6 +30,7 @@
 #include <sbi/sbi_string.h>
 #include <sbi/sbi_timer.h>
 #include <sbi/sbi_tlb.h>
+#include <sbi/sbi_trace.h>
 #include <sbi/sbi_version.h>
 
 #define BANNER                                              \
@@ -216,8 +219,10 @@ static void wait_for_coldboot(struct sbi_scratch *scratch, u32 hartid)
 	/* Release coldboot lock */
 	spin_unlock(&coldboot_lock);
 
-	/* Wait for coldboot to finish using WFI */
+	/* Wait for coldboot to finish using wait-on-address or WFI */
 	while (!__smp_load_acquire(&coldboot_done)) {
+		if (sbi_hart_wait_on_ulong(&coldboot_done, 0, false))
+			continue;
 		do {
 			wfi();
 			cmip = csr_read(CSR_MIP);
@@ -276,15 +281,20 @@ static void __noreturn init_coldboot(struct sbi_scratch *scratch, u32 hartid)
 	unsigned long *count;
 	const struct sbi_platform *plat = sbi_platform_ptr(scratch);
 
+	sbi_boot_prof_mark(SBI_BOOT_PHASE_SBI_ENTRY);
+
 	/* Note: This has to be first thing in coldboot init sequence */
 	rc = sbi_scratch_init(scratch);
 	if (rc)
 		sbi_hart_hang();
 
+	sbi_boot_prof_mark(SBI_BOOT_PHASE_SCRATCH);
+
 	/* Note: This has to be second thing in coldboot init sequence */
 	rc = sbi_heap_init(scratch);
 	if (rc)
 		sbi_hart_hang();
+	sbi_boot_prof_mark(SBI_BOOT_PHASE_HEAP);
 
 	/* Note: This has to be the third thing in coldboot init sequence */
 	rc = sbi_domain_init(scratch, hartid);
@@ -301,22 +311,32 @@ static void __noreturn init_coldboot(struct sbi_scratch *scratch, u32 hartid)
 
 	count = sbi_scratch_offset_ptr(scratch, entry_count_offset);
 	(*count)++;
+	sbi_boot_prof_mark(SBI_BOOT_PHASE_DOMAIN);
+
+	rc = sbi_trace_init(scratch, true);
+	if (rc)
+		sbi_hart_hang();
+	sbi_boot_prof_mark(SBI_BOOT_PHASE_TRACE);
 
 	rc = sbi_hsm_init(scratch, hartid, true);
 	if (rc)
 		sbi_hart_hang();
+	sbi_boot_prof_mark(SBI_BOOT_PHASE_HSM);
 
 	rc = sbi_platform_early_init(plat, true);
 	if (rc)
 		sbi_hart_hang();
+	sbi_boot_prof_mark(SBI_BOOT_PHASE_PLATFORM_EARLY);
 
 	rc = sbi_hart_init(scratch, true);
 	if (rc)
 		sbi_hart_hang();
+	sbi_boot_prof_mark(SBI_BOOT_PHASE_HART);
 
 	rc = sbi_console_init(scratch);
 	if (rc)
 		sbi_hart_hang();
+	sbi_boot_prof_mark(SBI_BOOT_PHASE_CONSOLE);
 
 	rc = sbi_pmu_init(scratch, true);
 	if (rc) {
@@ -324,12 +344,15 @@ static void __noreturn init_coldboot(struct sbi_scratch *scratch, u32 hartid)
 			   __func__, rc);
 		sbi_hart_hang();
 	}
+	sbi_boot_prof_mark(SBI_BOOT_PHASE_PMU);
 
 	rc = sbi_dbtr_init(scratch, true);
 	if (rc)
 		sbi_hart_hang();
+	sbi_boot_prof_mark(SBI_BOOT_PHASE_DBTR);
 
 	sbi_boot_print_banner(scratch);
+	sbi_boot_prof_mark(SBI_BOOT_PHASE_BANNER);
 
 	rc = sbi_irqchip_init(scratch, true);
 	if (rc) {
@@ -337,24 +360,36 @@ static void __noreturn init_coldboot(struct sbi_scratch *scratch, u32 hartid)
 			   __func__, rc);
 		sbi_hart_hang();
 	}
+	sbi_boot_prof_mark(SBI_BOOT_PHASE_IRQCHIP);
+
+	rc = sbi_console_irq_init(scratch);
+	if (rc) {
+		sbi_printf("%s: console irq init failed (error %d)\n",
+			   __func__, rc);
+		sbi_hart_hang();
+	}
+	sbi_boot_prof_mark(SBI_BOOT_PHASE_CONSOLE_IRQ);
 
 	rc = sbi_ipi_init(scratch, true);
 	if (rc) {
 		sbi_printf("%s: ipi init failed (error %d)\n", __func__, rc);
 		sbi_hart_hang();
 	}
+	sbi_boot_prof_mark(SBI_BOOT_PHASE_IPI);
 
 	rc = sbi_tlb_init(scratch, true);
 	if (rc) {
 		sbi_printf("%s: tlb init failed (error %d)\n", __func__, rc);
 		sbi_hart_hang();
 	}
+	sbi_boot_prof_mark(SBI_BOOT_PHASE_TLB);
 
 	rc = sbi_timer_init(scratch, true);
 	if (rc) {
 		sbi_printf("%s: timer init failed (error %d)\n", __func__, rc);
 		sbi_hart_hang();
 	}
+	sbi_boot_prof_mark(SBI_BOOT_PHASE_TIMER);
 
 	/*
 	 * Note: Finalize domains after HSM initialization so that we
@@ -369,6 +404,14 @@ static void __noreturn init_coldboot(struct sbi_scratch *scratch, u32 hartid)
 		sbi_hart_hang();
 	}
 
+	rc = sbi_domain_context_init();
+	if (rc) {
+		sbi_printf("%s: domain context init failed (error %d)\n",
+			   __func__, rc);
+		sbi_hart_hang();
+	}
+	sbi_boot_prof_mark(SBI_BOOT_PHASE_DOMAIN_FINALIZE);
+
 	/*
 	 * Note: Platform final initialization should be after finalizing
 	 * domains so that it sees correct domain assignment and PMP
@@ -380,6 +423,7 @@ static void __noreturn init_coldboot(struct sbi_scratch *scratch, u32 hartid)
 			   __func__, rc);
 		sbi_hart_hang();
 	}
+	sbi_boot_prof_mark(SBI_BOOT_PHASE_PLATFORM_FINAL);
 
 	/*
 	 * Note: Ecall initialization should be after platform final
@@ -391,12 +435,14 @@ static void __noreturn init_coldboot(struct sbi_scratch *scratch, u32 hartid)
 		sbi_printf("%s: ecall init failed (error %d)\n", __func__, rc);
 		sbi_hart_hang();
 	}
+	sbi_boot_prof_mark(SBI_BOOT_PHASE_ECALL);
 
 	sbi_boot_print_general(scratch);
 
 	sbi_boot_print_domains(scratch);
 
 	sbi_boot_print_hart(scratch, hartid);
+	sbi_boot_prof_mark(SBI_BOOT_PHASE_BOOT_PRINTS);
 
 	/*
 	 * Configure PMP at last because if SMEPMP is detected,
@@ -408,9 +454,14 @@ static void __noreturn init_coldboot(struct sbi_scratch *scratch, u32 hartid)
 			   __func__, rc);
 		sbi_hart_hang();
 	}
+	sbi_boot_prof_mark(SBI_BOOT_PHASE_PMP);
+
+	sbi_boot_prof_print(scratch);
 
 	wake_coldboot_harts(scratch, hartid);
 
+	sbi_hart_resume_save(scratch);
+
 	count = sbi_scratch_offset_ptr(scratch, init_count_offset);
 	(*count)++;
 
@@ -430,6 +481,10 @@ static void __noreturn init_warm_startup(struct sbi_scratch *scratch,
 	count = sbi_scratch_offset_ptr(scratch, entry_count_offset);
 	(*count)++;
 
+	rc = sbi_trace_init(scratch, false);
+	if (rc)
+		sbi_hart_hang();
+
 	rc = sbi_hsm_init(scratch, hartid, false);
 	if (rc)
 		sbi_hart_hang();
@@ -478,6 +533,8 @@ static void __noreturn init_warm_startup(struct sbi_scratch *scratch,
 	if (rc)
 		sbi_hart_hang();
 
+	sbi_hart_resume_save(scratch);
+
 	count = sbi_scratch_offset_ptr(scratch, init_count_offset);
 	(*count)++;
 
@@ -491,13 +548,21 @@ static void __noreturn init_warm_resume(struct sbi_scratch *scratch,
 
 	sbi_hsm_hart_resume_start(scratch);
 
-	rc = sbi_hart_reinit(scratch);
-	if (rc)
-		sbi_hart_hang();
+	/* Replay the state saved at boot unless the hart config changed */
+	if (sbi_hart_resume_restore(scratch)) {
+		rc = sbi_hart_reinit(scratch);
+		if (rc)
+			sbi_hart_hang();
 
-	rc = sbi_hart_pmp_configure(scratch);
-	if (rc)
-		sbi_hart_hang();
+		rc = sbi_hart_pmp_configure(scratch);
+		if (rc)
+			sbi_hart_hang();
+
+		sbi_hart_resume_save(scratch);
+	}
+
+	/* Irqchip context of this hart may have been lost while suspended */
+	sbi_irqchip_reroute();
 
 	sbi_hsm_hart_resume_finish(scratch, hartid);
 }
@@ -656,6 +721,8 @@ void __noreturn sbi_exit(struct sbi_scratch *scratch)
 
 	sbi_ipi_exit(scratch);
 
+	sbi_console_exit(scratch);
+
 	sbi_irqchip_exit(scratch);
 
 	sbi_platform_final_exit(plat);
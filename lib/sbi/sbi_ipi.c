@@ -234,6 +234,7 @@ void sbi_ipi_process(void)
 	struct sbi_ipi_data *ipi_data =
 			sbi_scratch_offset_ptr(scratch, ipi_data_off);
 	u32 hartindex = sbi_hartid_to_hartindex(current_hartid());
+	unsigned long res_start = sbi_pmu_residency_start();
 
 	sbi_pmu_ctr_incr_fw(SBI_PMU_FW_IPI_RECVD);
 	sbi_ipi_raw_clear(hartindex);
@@ -249,6 +250,8 @@ void sbi_ipi_process(void)
 		ipi_type = ipi_type >> 1;
 		ipi_event++;
 	}
+
+	sbi_pmu_residency_end(SBI_PMU_FW_RES_IPI, res_start);
 }
 
 int sbi_ipi_raw_send(u32 hartindex)
@@ -271,6 +274,27 @@ int sbi_ipi_raw_send(u32 hartindex)
 	return 0;
 }
 
+int sbi_ipi_raw_send_many(const struct sbi_hartmask *mask)
+{
+	u32 i;
+
+	/* Nothing to send is not an error even without an IPI device */
+	if (find_first_bit(mask->bits, SBI_HARTMASK_MAX_BITS) >=
+	    SBI_HARTMASK_MAX_BITS)
+		return 0;
+
+	if (!ipi_dev || !ipi_dev->ipi_send)
+		return SBI_EINVAL;
+
+	/* Same ordering as sbi_ipi_raw_send() with a single barrier */
+	wmb();
+
+	sbi_hartmask_for_each_hartindex(i, mask)
+		ipi_dev->ipi_send(i);
+
+	return 0;
+}
+
 void sbi_ipi_raw_clear(u32 hartindex)
 {
 	if (ipi_dev && ipi_dev->ipi_clear)
@@ -7,9 +7,24 @@
  *   Anup Patel <apatel@ventanamicro.com>
  */
 
+#include <sbi/riscv_locks.h>
+#include <sbi/sbi_error.h>
 #include <sbi/sbi_irqchip.h>
 #include <sbi/sbi_platform.h>
 
+#define SBI_IRQCHIP_MAX_HANDLERS	8
+
+struct sbi_irqchip_handler {
+	u32 hwirq;
+	/* HART whose M-mode the source is routed to */
+	u32 hartindex;
+	int (*fn)(u32 hwirq, void *priv);
+	void *priv;
+};
+
+static struct sbi_irqchip_handler hwirq_handlers[SBI_IRQCHIP_MAX_HANDLERS];
+static spinlock_t hwirq_handlers_lock = SPIN_LOCK_INITIALIZER;
+
 static int default_irqfn(struct sbi_trap_regs *regs)
 {
 	return SBI_ENODEV;
@@ -23,6 +38,105 @@ void sbi_irqchip_set_irqfn(int (*fn)(struct sbi_trap_regs *regs))
 		ext_irqfn = fn;
 }
 
+static int default_routefn(u32 hwirq, bool enable)
+{
+	return SBI_ENODEV;
+}
+
+static int (*ext_routefn)(u32 hwirq, bool enable) = default_routefn;
+
+void sbi_irqchip_set_routefn(int (*fn)(u32 hwirq, bool enable))
+{
+	if (fn)
+		ext_routefn = fn;
+}
+
+int sbi_irqchip_register_handler(u32 hwirq,
+				 int (*fn)(u32 hwirq, void *priv), void *priv)
+{
+	int i, rc = SBI_ENOSPC;
+	struct sbi_irqchip_handler *h;
+
+	if (!hwirq || !fn)
+		return SBI_EINVAL;
+
+	spin_lock(&hwirq_handlers_lock);
+
+	for (i = 0; i < SBI_IRQCHIP_MAX_HANDLERS; i++) {
+		h = &hwirq_handlers[i];
+		if (h->fn && h->hwirq == hwirq) {
+			rc = SBI_EALREADY;
+			break;
+		}
+		if (h->fn)
+			continue;
+
+		rc = ext_routefn(hwirq, true);
+		if (!rc) {
+			h->hwirq = hwirq;
+			h->hartindex = sbi_hartid_to_hartindex(current_hartid());
+			h->priv = priv;
+			h->fn = fn;
+		}
+		break;
+	}
+
+	spin_unlock(&hwirq_handlers_lock);
+
+	return rc;
+}
+
+void sbi_irqchip_unregister_handler(u32 hwirq)
+{
+	int i;
+	struct sbi_irqchip_handler *h;
+
+	spin_lock(&hwirq_handlers_lock);
+
+	for (i = 0; i < SBI_IRQCHIP_MAX_HANDLERS; i++) {
+		h = &hwirq_handlers[i];
+		if (!h->fn || h->hwirq != hwirq)
+			continue;
+
+		ext_routefn(hwirq, false);
+		h->fn = NULL;
+		break;
+	}
+
+	spin_unlock(&hwirq_handlers_lock);
+}
+
+void sbi_irqchip_reroute(void)
+{
+	int i;
+	struct sbi_irqchip_handler *h;
+	u32 hartindex = sbi_hartid_to_hartindex(current_hartid());
+
+	spin_lock(&hwirq_handlers_lock);
+
+	for (i = 0; i < SBI_IRQCHIP_MAX_HANDLERS; i++) {
+		h = &hwirq_handlers[i];
+		if (h->fn && h->hartindex == hartindex)
+			ext_routefn(h->hwirq, true);
+	}
+
+	spin_unlock(&hwirq_handlers_lock);
+}
+
+int sbi_irqchip_process_hwirq(u32 hwirq)
+{
+	int i;
+	struct sbi_irqchip_handler *h;
+
+	for (i = 0; i < SBI_IRQCHIP_MAX_HANDLERS; i++) {
+		h = &hwirq_handlers[i];
+		if (h->fn && h->hwirq == hwirq)
+			return h->fn(hwirq, h->priv);
+	}
+
+	return SBI_ENOENT;
+}
+
 int sbi_irqchip_process(struct sbi_trap_regs *regs)
 {
 	return ext_irqfn(regs);
@@ -37,6 +151,9 @@ int sbi_irqchip_init(struct sbi_scratch *scratch, bool cold_boot)
 	if (rc)
 		return rc;
 
+	/* Warm init of the irqchip resets the routes of this HART */
+	sbi_irqchip_reroute();
+
 	if (ext_irqfn != default_irqfn)
 		csr_set(CSR_MIE, MIP_MEIP);
 
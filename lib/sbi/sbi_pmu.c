@@ -10,6 +10,7 @@
 #include <sbi/riscv_asm.h>
 #include <sbi/sbi_bitops.h>
 #include <sbi/sbi_console.h>
+#include <sbi/sbi_domain.h>
 #include <sbi/sbi_ecall_interface.h>
 #include <sbi/sbi_hart.h>
 #include <sbi/sbi_heap.h>
@@ -54,6 +55,15 @@ union sbi_pmu_ctr_info {
 #error "Can't handle firmware counters beyond BITS_PER_LONG"
 #endif
 
+_Static_assert(sizeof(struct sbi_pmu_snapshot) == SBI_PMU_SNAPSHOT_SHMEM_SIZE,
+	       "struct sbi_pmu_snapshot must match the snapshot size");
+
+/** Snapshot shared memory address when it is disabled */
+#define PMU_SNAPSHOT_INVALID_ADDR	-1UL
+
+/* SBI firmware events and residency events tracked per counter */
+#define PMU_FW_EVENT_SLOTS	(SBI_PMU_FW_MAX + SBI_PMU_FW_RES_COUNT)
+
 /** Per-HART state of the PMU counters */
 struct sbi_pmu_hart_state {
 	/* HART to which this state belongs */
@@ -62,12 +72,18 @@ struct sbi_pmu_hart_state {
 	uint32_t active_events[SBI_PMU_HW_CTR_MAX + SBI_PMU_FW_CTR_MAX];
 	/* Bitmap of firmware counters started */
 	unsigned long fw_counters_started;
+	/* Bitmap of firmware counters overflowed since they were started */
+	unsigned long fw_counters_overflow;
+	/* Bitmap of started firmware counters for each SBI firmware event */
+	unsigned long fw_event_counters[PMU_FW_EVENT_SLOTS];
 	/*
 	 * Counter values for SBI firmware events and event codes
 	 * for platform firmware events. Both are mutually exclusive
 	 * and hence can optimally share the same memory.
 	 */
 	uint64_t fw_counters_data[SBI_PMU_FW_CTR_MAX];
+	/* Physical address of the snapshot shared memory */
+	unsigned long snapshot_addr;
 };
 
 /** Offset of pointer to PMU HART state in scratch space */
@@ -101,6 +117,45 @@ static uint32_t total_ctrs;
   (((x) & SBI_PMU_EVENT_IDX_TYPE_MASK) >> SBI_PMU_EVENT_IDX_TYPE_OFFSET)
 #define get_cidx_code(x) (x & SBI_PMU_EVENT_IDX_CODE_MASK)
 
+/* Index of a firmware event in fw_event_counters[] or -1 */
+static inline int pmu_fw_event_slot(uint32_t event_code)
+{
+	if (event_code < SBI_PMU_FW_MAX)
+		return event_code;
+#ifdef CONFIG_SBI_PMU_FW_RESIDENCY
+	if (event_code >= SBI_PMU_FW_RES_BASE &&
+	    event_code < SBI_PMU_FW_RES_MAX)
+		return SBI_PMU_FW_MAX + event_code - SBI_PMU_FW_RES_BASE;
+#endif
+	return -1;
+}
+
+static inline bool pmu_fw_event_code_valid(uint32_t event_code)
+{
+	return event_code == SBI_PMU_FW_PLATFORM ||
+	       pmu_fw_event_slot(event_code) >= 0;
+}
+
+static void pmu_fw_counter_mark_started(struct sbi_pmu_hart_state *phs,
+					uint32_t cidx, uint32_t event_code)
+{
+	int slot = pmu_fw_event_slot(event_code);
+
+	phs->fw_counters_started |= BIT(cidx - num_hw_ctrs);
+	if (slot >= 0)
+		phs->fw_event_counters[slot] |= BIT(cidx - num_hw_ctrs);
+}
+
+static void pmu_fw_counter_mark_stopped(struct sbi_pmu_hart_state *phs,
+					uint32_t cidx, uint32_t event_code)
+{
+	int slot = pmu_fw_event_slot(event_code);
+
+	phs->fw_counters_started &= ~BIT(cidx - num_hw_ctrs);
+	if (slot >= 0)
+		phs->fw_event_counters[slot] &= ~BIT(cidx - num_hw_ctrs);
+}
+
 /**
  * Perform a sanity check on event & counter mappings with event range overlap check
  * @param evtA Pointer to the existing hw event structure
@@ -140,17 +195,17 @@ static int pmu_event_validate(struct sbi_pmu_hart_state *phs,
 		event_idx_code_max = SBI_PMU_HW_GENERAL_MAX;
 		break;
 	case SBI_PMU_EVENT_TYPE_FW:
-		if ((event_idx_code >= SBI_PMU_FW_MAX &&
-		    event_idx_code <= SBI_PMU_FW_RESERVED_MAX) ||
-		    event_idx_code > SBI_PMU_FW_PLATFORM)
+		if (!pmu_fw_event_code_valid(event_idx_code))
 			return SBI_EINVAL;
 
 		if (SBI_PMU_FW_PLATFORM == event_idx_code &&
 		    pmu_dev && pmu_dev->fw_event_validate_encoding)
 			return pmu_dev->fw_event_validate_encoding(phs->hartid,
 							           edata);
+		else if (pmu_fw_event_slot(event_idx_code) >= 0)
+			return event_idx_type;
 		else
-			event_idx_code_max = SBI_PMU_FW_MAX;
+			return SBI_EINVAL;
 		break;
 	case SBI_PMU_EVENT_TYPE_HW_CACHE:
 		cache_ops_result = event_idx_code &
@@ -211,9 +266,7 @@ int sbi_pmu_ctr_fw_read(uint32_t cidx, uint64_t *cval)
 	if (event_idx_type != SBI_PMU_EVENT_TYPE_FW)
 		return SBI_EINVAL;
 
-	if ((event_code >= SBI_PMU_FW_MAX &&
-	    event_code <= SBI_PMU_FW_RESERVED_MAX) ||
-	    event_code > SBI_PMU_FW_PLATFORM)
+	if (!pmu_fw_event_code_valid(event_code))
 		return SBI_EINVAL;
 
 	if (SBI_PMU_FW_PLATFORM == event_code) {
@@ -344,6 +397,36 @@ static void pmu_ctr_write_hw(uint32_t cidx, uint64_t ival)
 #endif
 }
 
+static uint64_t pmu_ctr_read_hw(uint32_t cidx)
+{
+#if __riscv_xlen == 32
+	uint32_t lo, hi;
+
+	do {
+		hi = csr_read_num(CSR_MCYCLEH + cidx);
+		lo = csr_read_num(CSR_MCYCLE + cidx);
+	} while (hi != csr_read_num(CSR_MCYCLEH + cidx));
+
+	return ((uint64_t)hi << 32) | lo;
+#else
+	return csr_read_num(CSR_MCYCLE + cidx);
+#endif
+}
+
+static bool pmu_ctr_overflowed_hw(uint32_t cidx)
+{
+	if (cidx < 3 || cidx >= num_hw_ctrs ||
+	    !sbi_hart_has_extension(sbi_scratch_thishart_ptr(),
+				    SBI_HART_EXT_SSCOFPMF))
+		return false;
+
+#if __riscv_xlen == 32
+	return csr_read_num(CSR_MHPMEVENT3H + cidx - 3) & MHPMEVENTH_OF;
+#else
+	return csr_read_num(CSR_MHPMEVENT3 + cidx - 3) & MHPMEVENT_OF;
+#endif
+}
+
 static int pmu_ctr_start_hw(uint32_t cidx, uint64_t ival, bool ival_update)
 {
 	struct sbi_scratch *scratch = sbi_scratch_thishart_ptr();
@@ -398,9 +481,7 @@ static int pmu_ctr_start_fw(struct sbi_pmu_hart_state *phs,
 			    uint64_t event_data, uint64_t ival,
 			    bool ival_update)
 {
-	if ((event_code >= SBI_PMU_FW_MAX &&
-	    event_code <= SBI_PMU_FW_RESERVED_MAX) ||
-	    event_code > SBI_PMU_FW_PLATFORM)
+	if (!pmu_fw_event_code_valid(event_code))
 		return SBI_EINVAL;
 
 	if (SBI_PMU_FW_PLATFORM == event_code) {
@@ -421,13 +502,68 @@ static int pmu_ctr_start_fw(struct sbi_pmu_hart_state *phs,
 	} else {
 		if (ival_update)
 			phs->fw_counters_data[cidx - num_hw_ctrs] = ival;
+		/*
+		 * Same as the OF bit of hardware counters, re-arm the
+		 * overflow interrupt only when software has already
+		 * handled the previous one.
+		 */
+		if (!(csr_read(CSR_MIP) & sbi_pmu_irq_bit()))
+			phs->fw_counters_overflow &= ~BIT(cidx - num_hw_ctrs);
 	}
 
-	phs->fw_counters_started |= BIT(cidx - num_hw_ctrs);
+	pmu_fw_counter_mark_started(phs, cidx, event_code);
 
 	return 0;
 }
 
+static uint64_t pmu_snapshot_read_value(struct sbi_pmu_hart_state *phs,
+					int idx)
+{
+	struct sbi_pmu_snapshot *snap =
+			(struct sbi_pmu_snapshot *)phs->snapshot_addr;
+	uint64_t val;
+
+	sbi_hart_map_saddr(phs->snapshot_addr, sizeof(*snap));
+	val = snap->ctr_values[idx];
+	sbi_hart_unmap_saddr();
+
+	return val;
+}
+
+static void pmu_snapshot_take(struct sbi_pmu_hart_state *phs,
+			      unsigned long cbase, unsigned long cmask)
+{
+	struct sbi_pmu_snapshot *snap =
+			(struct sbi_pmu_snapshot *)phs->snapshot_addr;
+	uint64_t val, of_mask = 0;
+	uint32_t event_code;
+	int i, cidx, type;
+
+	sbi_hart_map_saddr(phs->snapshot_addr, sizeof(*snap));
+
+	for_each_set_bit(i, &cmask, BITS_PER_LONG) {
+		cidx = i + cbase;
+		type = pmu_ctr_validate(phs, cidx, &event_code);
+		if (type < 0)
+			continue;
+
+		if (type == SBI_PMU_EVENT_TYPE_FW) {
+			if (sbi_pmu_ctr_fw_read(cidx, &val))
+				continue;
+			if (phs->fw_counters_overflow & BIT(cidx - num_hw_ctrs))
+				of_mask |= BIT(i);
+		} else {
+			val = pmu_ctr_read_hw(cidx);
+			if (pmu_ctr_overflowed_hw(cidx))
+				of_mask |= BIT(i);
+		}
+		snap->ctr_values[i] = val;
+	}
+	snap->ctr_overflow_mask = of_mask;
+
+	sbi_hart_unmap_saddr();
+}
+
 int sbi_pmu_ctr_start(unsigned long cbase, unsigned long cmask,
 		      unsigned long flags, uint64_t ival)
 {
@@ -442,10 +578,12 @@ int sbi_pmu_ctr_start(unsigned long cbase, unsigned long cmask,
 	if ((cbase + sbi_fls(cmask)) >= total_ctrs)
 		return ret;
 
-	if (flags & SBI_PMU_STOP_FLAG_TAKE_SNAPSHOT)
+	if ((flags & SBI_PMU_START_FLAG_INIT_FROM_SNAPSHOT) &&
+	    phs->snapshot_addr == PMU_SNAPSHOT_INVALID_ADDR)
 		return SBI_ENO_SHMEM;
 
-	if (flags & SBI_PMU_START_FLAG_SET_INIT_VALUE)
+	if (flags & (SBI_PMU_START_FLAG_SET_INIT_VALUE |
+		     SBI_PMU_START_FLAG_INIT_FROM_SNAPSHOT))
 		bUpdate = true;
 
 	for_each_set_bit(i, &cmask, BITS_PER_LONG) {
@@ -454,7 +592,11 @@ int sbi_pmu_ctr_start(unsigned long cbase, unsigned long cmask,
 		if (event_idx_type < 0)
 			/* Continue the start operation for other counters */
 			continue;
-		else if (event_idx_type == SBI_PMU_EVENT_TYPE_FW) {
+
+		if (flags & SBI_PMU_START_FLAG_INIT_FROM_SNAPSHOT)
+			ival = pmu_snapshot_read_value(phs, i);
+
+		if (event_idx_type == SBI_PMU_EVENT_TYPE_FW) {
 			edata = (event_code == SBI_PMU_FW_PLATFORM) ?
 				 phs->fw_counters_data[cidx - num_hw_ctrs]
 				 : 0x0;
@@ -498,9 +640,7 @@ static int pmu_ctr_stop_fw(struct sbi_pmu_hart_state *phs,
 {
 	int ret;
 
-	if ((event_code >= SBI_PMU_FW_MAX &&
-	    event_code <= SBI_PMU_FW_RESERVED_MAX) ||
-	    event_code > SBI_PMU_FW_PLATFORM)
+	if (!pmu_fw_event_code_valid(event_code))
 		return SBI_EINVAL;
 
 	if (SBI_PMU_FW_PLATFORM == event_code &&
@@ -510,7 +650,7 @@ static int pmu_ctr_stop_fw(struct sbi_pmu_hart_state *phs,
 			return ret;
 	}
 
-	phs->fw_counters_started &= ~BIT(cidx - num_hw_ctrs);
+	pmu_fw_counter_mark_stopped(phs, cidx, event_code);
 
 	return 0;
 }
@@ -543,7 +683,8 @@ int sbi_pmu_ctr_stop(unsigned long cbase, unsigned long cmask,
 	if ((cbase + sbi_fls(cmask)) >= total_ctrs)
 		return SBI_EINVAL;
 
-	if (flag & SBI_PMU_STOP_FLAG_TAKE_SNAPSHOT)
+	if ((flag & SBI_PMU_STOP_FLAG_TAKE_SNAPSHOT) &&
+	    phs->snapshot_addr == PMU_SNAPSHOT_INVALID_ADDR)
 		return SBI_ENO_SHMEM;
 
 	for_each_set_bit(i, &cmask, BITS_PER_LONG) {
@@ -557,8 +698,21 @@ int sbi_pmu_ctr_stop(unsigned long cbase, unsigned long cmask,
 			ret = pmu_ctr_stop_fw(phs, cidx, event_code);
 		else
 			ret = pmu_ctr_stop_hw(cidx);
+	}
+
+	/* Save the stopped counters before they are reset */
+	if (flag & SBI_PMU_STOP_FLAG_TAKE_SNAPSHOT)
+		pmu_snapshot_take(phs, cbase, cmask);
 
-		if (cidx > (CSR_INSTRET - CSR_CYCLE) && flag & SBI_PMU_STOP_FLAG_RESET) {
+	if (!(flag & SBI_PMU_STOP_FLAG_RESET))
+		return ret;
+
+	for_each_set_bit(i, &cmask, BITS_PER_LONG) {
+		cidx = i + cbase;
+		if (pmu_ctr_validate(phs, cidx, &event_code) < 0)
+			continue;
+
+		if (cidx > (CSR_INSTRET - CSR_CYCLE)) {
 			phs->active_events[cidx] = SBI_PMU_EVENT_IDX_INVALID;
 			pmu_reset_hw_mhpmevent(cidx);
 		}
@@ -764,9 +918,7 @@ static int pmu_ctr_find_fw(struct sbi_pmu_hart_state *phs,
 {
 	int i, cidx;
 
-	if ((event_code >= SBI_PMU_FW_MAX &&
-	    event_code <= SBI_PMU_FW_RESERVED_MAX) ||
-	    event_code > SBI_PMU_FW_PLATFORM)
+	if (!pmu_fw_event_code_valid(event_code))
 		return SBI_EINVAL;
 
 	for_each_set_bit(i, &cmask, BITS_PER_LONG) {
@@ -856,17 +1008,49 @@ skip_match:
 				if (ret)
 					return ret;
 			}
-			phs->fw_counters_started |= BIT(ctr_idx - num_hw_ctrs);
+			pmu_fw_counter_mark_started(phs, ctr_idx, event_code);
 		}
 	}
 
 	return ctr_idx;
 }
 
+static void pmu_ctr_overflow_fw(struct sbi_pmu_hart_state *phs, int fidx)
+{
+	int irq_bit;
+
+	/* Only one overflow interrupt until the counter is re-armed */
+	if (phs->fw_counters_overflow & BIT(fidx))
+		return;
+	phs->fw_counters_overflow |= BIT(fidx);
+
+	/* Raise the counter overflow interrupt for S-mode */
+	irq_bit = sbi_pmu_irq_bit();
+	if (irq_bit)
+		csr_set(CSR_MIP, irq_bit);
+}
+
+static void pmu_ctr_add_fw(struct sbi_pmu_hart_state *phs, int slot,
+			   uint64_t val)
+{
+	unsigned long ctrs = phs->fw_event_counters[slot];
+	uint64_t old;
+	int fidx;
+
+	/* Usually a single counter tracks an event so this is one add */
+	while (ctrs) {
+		fidx = sbi_ffs(ctrs);
+		old = phs->fw_counters_data[fidx];
+		phs->fw_counters_data[fidx] = old + val;
+		/* Counter wrapped around so it overflowed */
+		if (phs->fw_counters_data[fidx] < old)
+			pmu_ctr_overflow_fw(phs, fidx);
+		ctrs &= ctrs - 1;
+	}
+}
+
 int sbi_pmu_ctr_incr_fw(enum sbi_pmu_fw_event_code_id fw_id)
 {
-	u32 cidx;
-	uint64_t *fcounter = NULL;
 	struct sbi_pmu_hart_state *phs = pmu_thishart_state_ptr();
 
 	if (likely(!phs->fw_counters_started))
@@ -875,16 +1059,67 @@ int sbi_pmu_ctr_incr_fw(enum sbi_pmu_fw_event_code_id fw_id)
 	if (unlikely(fw_id >= SBI_PMU_FW_MAX))
 		return SBI_EINVAL;
 
-	for (cidx = num_hw_ctrs; cidx < total_ctrs; cidx++) {
-		if (get_cidx_code(phs->active_events[cidx]) == fw_id &&
-		    (phs->fw_counters_started & BIT(cidx - num_hw_ctrs))) {
-			fcounter = &phs->fw_counters_data[cidx - num_hw_ctrs];
-			break;
-		}
+	pmu_ctr_add_fw(phs, fw_id, 1);
+
+	return 0;
+}
+
+#ifdef CONFIG_SBI_PMU_FW_RESIDENCY
+int sbi_pmu_ctr_add_fw(uint32_t fw_id, uint64_t val)
+{
+	struct sbi_pmu_hart_state *phs;
+	int slot;
+
+	/* Residency is measured for traps taken before PMU init as well */
+	if (unlikely(!phs_ptr_offset))
+		return 0;
+
+	phs = pmu_thishart_state_ptr();
+	if (likely(!phs || !phs->fw_counters_started))
+		return 0;
+
+	slot = pmu_fw_event_slot(fw_id);
+	if (unlikely(slot < 0))
+		return SBI_EINVAL;
+
+	pmu_ctr_add_fw(phs, slot, val);
+
+	return 0;
+}
+#endif
+
+int sbi_pmu_snapshot_set_shmem(unsigned long shmem_phys_lo,
+			       unsigned long shmem_phys_hi,
+			       unsigned long flags)
+{
+	struct sbi_pmu_hart_state *phs = pmu_thishart_state_ptr();
+	unsigned long smode = (csr_read(CSR_MSTATUS) & MSTATUS_MPP) >>
+			      MSTATUS_MPP_SHIFT;
+
+	if (flags)
+		return SBI_EINVAL;
+
+	/* Request to disable the snapshot shared memory */
+	if (shmem_phys_lo == PMU_SNAPSHOT_INVALID_ADDR &&
+	    shmem_phys_hi == PMU_SNAPSHOT_INVALID_ADDR) {
+		phs->snapshot_addr = PMU_SNAPSHOT_INVALID_ADDR;
+		return 0;
 	}
 
-	if (fcounter)
-		(*fcounter)++;
+	if (shmem_phys_lo & (SBI_PMU_SNAPSHOT_SHMEM_SIZE - 1))
+		return SBI_EINVAL;
+
+	/* M-mode can't access the shared memory above XLEN bits */
+	if (shmem_phys_hi)
+		return SBI_EINVALID_ADDR;
+
+	if (!sbi_domain_check_addr_range(sbi_domain_thishart_ptr(),
+					 shmem_phys_lo,
+					 SBI_PMU_SNAPSHOT_SHMEM_SIZE, smode,
+					 SBI_DOMAIN_READ | SBI_DOMAIN_WRITE))
+		return SBI_EINVALID_ADDR;
+
+	phs->snapshot_addr = shmem_phys_lo;
 
 	return 0;
 }
@@ -943,7 +1178,10 @@ static void pmu_reset_event_map(struct sbi_pmu_hart_state *phs)
 		phs->active_events[j] = SBI_PMU_EVENT_IDX_INVALID;
 	for (j = 0; j < SBI_PMU_FW_CTR_MAX; j++)
 		phs->fw_counters_data[j] = 0;
+	for (j = 0; j < PMU_FW_EVENT_SLOTS; j++)
+		phs->fw_event_counters[j] = 0;
 	phs->fw_counters_started = 0;
+	phs->fw_counters_overflow = 0;
 }
 
 const struct sbi_pmu_device *sbi_pmu_get_device(void)
@@ -961,13 +1199,17 @@ void sbi_pmu_set_device(const struct sbi_pmu_device *dev)
 
 void sbi_pmu_exit(struct sbi_scratch *scratch)
 {
+	struct sbi_pmu_hart_state *phs;
+
 	if (sbi_hart_priv_version(scratch) >= SBI_HART_PRIV_VER_1_11)
 		csr_write(CSR_MCOUNTINHIBIT, 0xFFFFFFF8);
 
 	if (sbi_hart_priv_version(scratch) >= SBI_HART_PRIV_VER_1_10)
 		csr_write(CSR_MCOUNTEREN, -1);
 
-	pmu_reset_event_map(pmu_get_hart_state_ptr(scratch));
+	phs = pmu_get_hart_state_ptr(scratch);
+	pmu_reset_event_map(phs);
+	phs->snapshot_addr = PMU_SNAPSHOT_INVALID_ADDR;
 }
 
 int sbi_pmu_init(struct sbi_scratch *scratch, bool cold_boot)
@@ -1019,6 +1261,7 @@ int sbi_pmu_init(struct sbi_scratch *scratch, bool cold_boot)
 	}
 
 	pmu_reset_event_map(phs);
+	phs->snapshot_addr = PMU_SNAPSHOT_INVALID_ADDR;
 
 	/* First three counters are fixed by the priv spec and we enable it by default */
 	phs->active_events[0] = (SBI_PMU_EVENT_TYPE_HW << SBI_PMU_EVENT_IDX_TYPE_OFFSET) |
@@ -12,6 +12,7 @@
 #include <sbi/riscv_encoding.h>
 #include <sbi/sbi_console.h>
 #include <sbi/sbi_error.h>
+#include <sbi/sbi_fw_timer.h>
 #include <sbi/sbi_hart.h>
 #include <sbi/sbi_platform.h>
 #include <sbi/sbi_pmu.h>
@@ -19,6 +20,7 @@
 #include <sbi/sbi_timer.h>
 
 static unsigned long time_delta_off;
+static unsigned long next_event_off;
 static u64 (*get_time_val)(void);
 static const struct sbi_timer_device *timer_dev = NULL;
 
@@ -129,38 +131,126 @@ void sbi_timer_set_delta_upper(ulong delta_upper)
 	*time_delta |= ((u64)delta_upper << 32);
 }
 
+static u64 smode_next_event(struct sbi_scratch *scratch)
+{
+	/* With Sstc, S-mode may program stimecmp without an ecall */
+	if (sbi_hart_has_extension(scratch, SBI_HART_EXT_SSTC)) {
+#if __riscv_xlen == 32
+		return ((u64)csr_read(CSR_STIMECMPH) << 32) |
+		       csr_read(CSR_STIMECMP);
+#else
+		return csr_read(CSR_STIMECMP);
+#endif
+	}
+
+	if (!next_event_off)
+		return -1ULL;
+
+	return *(u64 *)sbi_scratch_offset_ptr(scratch, next_event_off);
+}
+
+u64 sbi_timer_next_event(void)
+{
+	struct sbi_scratch *scratch = sbi_scratch_thishart_ptr();
+	u64 next = smode_next_event(scratch);
+	u64 fw_next = sbi_fw_timer_next(scratch);
+
+	return (fw_next < next) ? fw_next : next;
+}
+
 void sbi_timer_event_start(u64 next_event)
 {
+	struct sbi_scratch *scratch = sbi_scratch_thishart_ptr();
+	u64 fw_next = sbi_fw_timer_next(scratch);
+
 	sbi_pmu_ctr_incr_fw(SBI_PMU_FW_SET_TIMER);
 
+	if (next_event_off)
+		*(u64 *)sbi_scratch_offset_ptr(scratch,
+					       next_event_off) = next_event;
+
 	/**
 	 * Update the stimecmp directly if available. This allows
 	 * the older software to leverage sstc extension on newer hardware.
 	 */
-	if (sbi_hart_has_extension(sbi_scratch_thishart_ptr(), SBI_HART_EXT_SSTC)) {
+	if (sbi_hart_has_extension(scratch, SBI_HART_EXT_SSTC)) {
 #if __riscv_xlen == 32
 		csr_write(CSR_STIMECMP, next_event & 0xFFFFFFFF);
 		csr_write(CSR_STIMECMPH, next_event >> 32);
 #else
 		csr_write(CSR_STIMECMP, next_event);
 #endif
+		/* The M-mode timer only serves firmware timers */
+		sbi_timer_rearm();
+		return;
 	} else if (timer_dev && timer_dev->timer_event_start) {
-		timer_dev->timer_event_start(next_event);
+		/* Firmware timers share the M-mode timer with S-mode */
+		timer_dev->timer_event_start((fw_next < next_event) ?
+					     fw_next : next_event);
 		csr_clear(CSR_MIP, MIP_STIP);
 	}
 	csr_set(CSR_MIE, MIP_MTIP);
 }
 
+void sbi_timer_rearm(void)
+{
+	struct sbi_scratch *scratch = sbi_scratch_thishart_ptr();
+	u64 next = sbi_fw_timer_next(scratch);
+
+	/*
+	 * With Sstc the S-mode timer event lives in stimecmp so the
+	 * M-mode timer only serves firmware timers.
+	 */
+	if (!sbi_hart_has_extension(scratch, SBI_HART_EXT_SSTC) &&
+	    next_event_off) {
+		if (smode_next_event(scratch) < next)
+			next = smode_next_event(scratch);
+	}
+
+	if (!timer_dev || !timer_dev->timer_event_start)
+		return;
+
+	/* Don't leave a past deadline behind to trap again */
+	if (next == -1ULL) {
+		csr_clear(CSR_MIE, MIP_MTIP);
+		if (timer_dev->timer_event_stop)
+			timer_dev->timer_event_stop();
+		return;
+	}
+
+	timer_dev->timer_event_start(next);
+	csr_set(CSR_MIE, MIP_MTIP);
+}
+
 void sbi_timer_process(void)
 {
+	struct sbi_scratch *scratch = sbi_scratch_thishart_ptr();
+	u64 *next_event = NULL;
+	u64 now = sbi_timer_value();
+
 	csr_clear(CSR_MIE, MIP_MTIP);
+	if (next_event_off)
+		next_event = sbi_scratch_offset_ptr(scratch, next_event_off);
+
 	/*
 	 * If sstc extension is available, supervisor can receive the timer
 	 * directly without M-mode come in between. This function should
 	 * only invoked if M-mode programs the timer for its own purpose.
+	 *
+	 * Otherwise the interrupt may have been raised for a firmware
+	 * timer only, in which case the S-mode timer event stays pending.
 	 */
-	if (!sbi_hart_has_extension(sbi_scratch_thishart_ptr(), SBI_HART_EXT_SSTC))
+	if (sbi_hart_has_extension(scratch, SBI_HART_EXT_SSTC)) {
+		if (next_event)
+			*next_event = -1ULL;
+	} else if (!next_event || !get_time_val || *next_event <= now) {
+		if (next_event)
+			*next_event = -1ULL;
 		csr_set(CSR_MIP, MIP_STIP);
+	}
+
+	sbi_fw_timer_process(scratch, now);
+	sbi_timer_rearm();
 }
 
 const struct sbi_timer_device *sbi_timer_get_device(void)
@@ -180,6 +270,7 @@ void sbi_timer_set_device(const struct sbi_timer_device *dev)
 
 int sbi_timer_init(struct sbi_scratch *scratch, bool cold_boot)
 {
+	int rc;
 	u64 *time_delta;
 	const struct sbi_platform *plat = sbi_platform_ptr(scratch);
 
@@ -188,6 +279,10 @@ int sbi_timer_init(struct sbi_scratch *scratch, bool cold_boot)
 		if (!time_delta_off)
 			return SBI_ENOMEM;
 
+		next_event_off = sbi_scratch_alloc_offset(sizeof(u64));
+		if (!next_event_off)
+			return SBI_ENOMEM;
+
 		if (sbi_hart_has_extension(scratch, SBI_HART_EXT_ZICNTR))
 			get_time_val = get_ticks;
 	} else {
@@ -197,6 +292,11 @@ int sbi_timer_init(struct sbi_scratch *scratch, bool cold_boot)
 
 	time_delta = sbi_scratch_offset_ptr(scratch, time_delta_off);
 	*time_delta = 0;
+	*(u64 *)sbi_scratch_offset_ptr(scratch, next_event_off) = -1ULL;
+
+	rc = sbi_fw_timer_init(scratch, cold_boot);
+	if (rc)
+		return rc;
 
 	return sbi_platform_timer_init(plat, cold_boot);
 }
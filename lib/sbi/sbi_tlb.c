@@ -18,6 +18,7 @@
 #include <sbi/sbi_ipi.h>
 #include <sbi/sbi_scratch.h>
 #include <sbi/sbi_tlb.h>
+#include <sbi/sbi_trace.h>
 #include <sbi/sbi_hfence.h>
 #include <sbi/sbi_string.h>
 #include <sbi/sbi_console.h>
@@ -242,20 +243,31 @@ static bool tlb_process_once(struct sbi_scratch *scratch)
 
 static void tlb_process(struct sbi_scratch *scratch)
 {
+	unsigned long res_start = sbi_pmu_residency_start();
+
 	while (tlb_process_once(scratch));
+
+	sbi_pmu_residency_end(SBI_PMU_FW_RES_TLB, res_start);
 }
 
 static void tlb_sync(struct sbi_scratch *scratch)
 {
 	atomic_t *tlb_sync =
 			sbi_scratch_offset_ptr(scratch, tlb_sync_off);
+	bool wrs = sbi_hart_can_wait_on_addr();
+	long sync;
 
-	while (atomic_read(tlb_sync) > 0) {
+	while ((sync = atomic_read(tlb_sync)) > 0) {
 		/*
 		 * While we are waiting for remote hart to set the sync,
-		 * consume fifo requests to avoid deadlock.
+		 * consume fifo requests to avoid deadlock. The wait uses
+		 * a short timeout so that new requests are picked up even
+		 * if they arrive without an interrupt.
 		 */
-		tlb_process_once(scratch);
+		if (!tlb_process_once(scratch) && wrs)
+			__sbi_hart_wait_on_ulong(
+				(volatile unsigned long *)&tlb_sync->counter,
+				sync, true);
 	}
 
 	return;
@@ -361,8 +373,8 @@ static int tlb_update(struct sbi_scratch *scratch,
 		 * this properly.
 		 */
 		tlb_process_once(scratch);
-		sbi_dprintf("hart%d: hart%d tlb fifo full\n", curr_hartid,
-			    sbi_hartindex_to_hartid(remote_hartindex));
+		sbi_trace("hart%d: hart%d tlb fifo full\n", curr_hartid,
+			  sbi_hartindex_to_hartid(remote_hartindex));
 		return SBI_IPI_UPDATE_RETRY;
 	}
 
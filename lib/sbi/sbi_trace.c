@@ -0,0 +1,130 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Copyright (c) 2026 OpenSBI contributors.
+ */
+
+#include <sbi/sbi_console.h>
+#include <sbi/sbi_error.h>
+#include <sbi/sbi_heap.h>
+#include <sbi/sbi_scratch.h>
+#include <sbi/sbi_string.h>
+#include <sbi/sbi_timer.h>
+#include <sbi/sbi_trace.h>
+
+struct sbi_trace_ring {
+	/** Total number of records ever written */
+	u32 head;
+	u32 reserved;
+	struct sbi_trace_entry entries[CONFIG_SBI_TRACE_ENTRIES];
+};
+
+static unsigned long trace_ring_off;
+
+static struct sbi_trace_ring *trace_ring_ptr(struct sbi_scratch *scratch)
+{
+	if (!trace_ring_off || !scratch)
+		return NULL;
+
+	return sbi_scratch_read_type(scratch, void *, trace_ring_off);
+}
+
+void __sbi_trace_record(const char *fmt, u32 nargs,
+			const unsigned long *args)
+{
+	u32 i;
+	struct sbi_trace_entry *e;
+	struct sbi_scratch *scratch = sbi_scratch_thishart_ptr();
+	struct sbi_trace_ring *ring = trace_ring_ptr(scratch);
+
+	/*
+	 * The ring is only written by its own HART with interrupts
+	 * disabled so no locking is needed.
+	 */
+	if (!ring)
+		return;
+
+	e = &ring->entries[ring->head % CONFIG_SBI_TRACE_ENTRIES];
+	e->time = sbi_timer_value();
+	e->fmt = (unsigned long)fmt - scratch->fw_start;
+	e->nargs = nargs;
+	for (i = 0; i < nargs; i++)
+		e->args[i] = args[i];
+	ring->head++;
+}
+
+int sbi_trace_read(u32 hartid, void *buf, unsigned long size)
+{
+	u32 i, count, first;
+	struct sbi_trace_header *hdr = buf;
+	struct sbi_trace_entry *out = (void *)(hdr + 1);
+	struct sbi_trace_ring *ring = trace_ring_ptr(sbi_hartid_to_scratch(hartid));
+
+	if (!ring)
+		return SBI_EINVAL;
+	if (size < sizeof(*hdr))
+		return SBI_EINVAL;
+	/* Records are stored directly so the buffer must be aligned */
+	if ((unsigned long)buf & (__alignof__(*out) - 1))
+		return SBI_EINVAL;
+
+	count = MIN(ring->head, (u32)CONFIG_SBI_TRACE_ENTRIES);
+	count = MIN(count, (u32)((size - sizeof(*hdr)) / sizeof(*out)));
+	first = ring->head - count;
+
+	hdr->magic = SBI_TRACE_MAGIC;
+	hdr->hartid = hartid;
+	hdr->count = count;
+	hdr->lost = first;
+	for (i = 0; i < count; i++)
+		sbi_memcpy(&out[i],
+			   &ring->entries[(first + i) % CONFIG_SBI_TRACE_ENTRIES],
+			   sizeof(*out));
+
+	return sizeof(*hdr) + count * sizeof(*out);
+}
+
+void sbi_trace_dump(u32 hartid)
+{
+	u32 i, j, pos, count;
+	struct sbi_trace_entry *e;
+	struct sbi_trace_ring *ring = trace_ring_ptr(sbi_hartid_to_scratch(hartid));
+
+	if (!ring)
+		return;
+
+	/* One line per record, expanded by scripts/sbi-trace-decode.py */
+	count = MIN(ring->head, (u32)CONFIG_SBI_TRACE_ENTRIES);
+	for (i = ring->head - count; i != ring->head; i++) {
+		pos = i % CONFIG_SBI_TRACE_ENTRIES;
+		e = &ring->entries[pos];
+		sbi_printf("sbi_trace: %u %llx %x", hartid,
+			   (unsigned long long)e->time, e->fmt);
+		for (j = 0; j < e->nargs; j++)
+			sbi_printf(" %llx", (unsigned long long)e->args[j]);
+		sbi_printf("\n");
+	}
+}
+
+int sbi_trace_init(struct sbi_scratch *scratch, bool cold_boot)
+{
+	struct sbi_trace_ring *ring;
+
+	if (cold_boot) {
+		trace_ring_off = sbi_scratch_alloc_type_offset(void *);
+		if (!trace_ring_off)
+			return SBI_ENOMEM;
+	} else if (!trace_ring_off)
+		return SBI_ENOMEM;
+
+	/* Keep the records of previous runs of this HART */
+	if (trace_ring_ptr(scratch))
+		return 0;
+
+	ring = sbi_zalloc(sizeof(*ring));
+	if (!ring)
+		return SBI_ENOMEM;
+	sbi_scratch_write_type(scratch, void *, trace_ring_off, ring);
+
+	return 0;
+}
@@ -21,6 +21,7 @@
 #include <sbi/sbi_pmu.h>
 #include <sbi/sbi_scratch.h>
 #include <sbi/sbi_timer.h>
+#include <sbi/sbi_trace.h>
 #include <sbi/sbi_trap.h>
 
 static void __noreturn sbi_trap_error(const char *msg, int rc,
@@ -71,6 +72,7 @@ static void __noreturn sbi_trap_error(const char *msg, int rc,
 		   hartid, "t4", regs->t4, "t5", regs->t5);
 	sbi_printf("%s: hart%d: %s=0x%" PRILX "\n", __func__, hartid, "t6",
 		   regs->t6);
+	sbi_trace_dump(hartid);
 
 	sbi_hart_hang();
 }
@@ -266,6 +268,7 @@ struct sbi_trap_regs *sbi_trap_handler(struct sbi_trap_regs *regs)
 	const char *msg = "trap handler failed";
 	ulong mcause = csr_read(CSR_MCAUSE);
 	ulong mtval = csr_read(CSR_MTVAL), mtval2 = 0, mtinst = 0;
+	unsigned long res_start = sbi_pmu_residency_start();
 	struct sbi_trap_info trap;
 
 	if (misa_extension('H')) {
@@ -283,6 +286,7 @@ struct sbi_trap_regs *sbi_trap_handler(struct sbi_trap_regs *regs)
 			msg = "unhandled local interrupt";
 			goto trap_error;
 		}
+		sbi_pmu_residency_end(SBI_PMU_FW_RES_TRAP, res_start);
 		return regs;
 	}
 
@@ -290,19 +294,23 @@ struct sbi_trap_regs *sbi_trap_handler(struct sbi_trap_regs *regs)
 	case CAUSE_ILLEGAL_INSTRUCTION:
 		rc  = sbi_illegal_insn_handler(mtval, regs);
 		msg = "illegal instruction handler failed";
+		sbi_pmu_residency_end(SBI_PMU_FW_RES_ILLEGAL_INSN, res_start);
 		break;
 	case CAUSE_MISALIGNED_LOAD:
 		rc = sbi_misaligned_load_handler(mtval, mtval2, mtinst, regs);
 		msg = "misaligned load handler failed";
+		sbi_pmu_residency_end(SBI_PMU_FW_RES_MISALIGNED, res_start);
 		break;
 	case CAUSE_MISALIGNED_STORE:
 		rc  = sbi_misaligned_store_handler(mtval, mtval2, mtinst, regs);
 		msg = "misaligned store handler failed";
+		sbi_pmu_residency_end(SBI_PMU_FW_RES_MISALIGNED, res_start);
 		break;
 	case CAUSE_SUPERVISOR_ECALL:
 	case CAUSE_MACHINE_ECALL:
 		rc  = sbi_ecall_handler(regs);
 		msg = "ecall handler failed";
+		sbi_pmu_residency_end(SBI_PMU_FW_RES_ECALL, res_start);
 		break;
 	case CAUSE_LOAD_ACCESS:
 	case CAUSE_STORE_ACCESS:
@@ -325,6 +333,7 @@ struct sbi_trap_regs *sbi_trap_handler(struct sbi_trap_regs *regs)
 trap_error:
 	if (rc)
 		sbi_trap_error(msg, rc, mcause, mtval, mtval2, mtinst, regs);
+	sbi_pmu_residency_end(SBI_PMU_FW_RES_TRAP, res_start);
 	return regs;
 }
 
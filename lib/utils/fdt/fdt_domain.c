@@ -17,6 +17,7 @@
 #include <sbi/sbi_scratch.h>
 #include <sbi_utils/fdt/fdt_domain.h>
 #include <sbi_utils/fdt/fdt_helper.h>
+#include <sbi_utils/fdt/fdt_index.h>
 
 int fdt_iterate_each_domain(void *fdt, void *opaque,
 			    int (*fn)(void *fdt, int domain_offset,
@@ -27,10 +28,10 @@ int fdt_iterate_each_domain(void *fdt, void *opaque,
 	if (!fdt || !fn)
 		return SBI_EINVAL;
 
-	poffset = fdt_path_offset(fdt, "/chosen");
+	poffset = fdt_index_path_offset(fdt, "/chosen");
 	if (poffset < 0)
 		return 0;
-	poffset = fdt_node_offset_by_compatible(fdt, poffset,
+	poffset = fdt_index_node_offset_by_compatible(fdt, poffset,
 						"opensbi,domain,config");
 	if (poffset < 0)
 		return 0;
@@ -70,7 +71,7 @@ int fdt_iterate_each_memregion(void *fdt, int domain_offset, void *opaque,
 
 	rcount = (u32)len / (sizeof(u32) * 2);
 	for (i = 0; i < rcount; i++) {
-		region_offset = fdt_node_offset_by_phandle(fdt,
+		region_offset = fdt_index_node_offset_by_phandle(fdt,
 						fdt32_to_cpu(regions[2 * i]));
 		if (region_offset < 0)
 			return region_offset;
@@ -139,12 +140,13 @@ static int __fixup_disable_devices(void *fdt, int doff, int roff,
 	len = len / sizeof(u32);
 
 	for (i = 0; i < len; i++) {
-		coff = fdt_node_offset_by_phandle(fdt,
+		coff = fdt_index_node_offset_by_phandle(fdt,
 					fdt32_to_cpu(devices[i]));
 		if (coff < 0)
 			return coff;
 
 		fdt_setprop_string(fdt, coff, "status", "disabled");
+		fdt_index_invalidate();
 	}
 
 	return 0;
@@ -158,7 +160,7 @@ void fdt_domain_fixup(void *fdt)
 	struct __fixup_find_domain_offset_info fdo;
 
 	/* Remove the domain assignment DT property from CPU DT nodes */
-	poffset = fdt_path_offset(fdt, "/cpus");
+	poffset = fdt_index_path_offset(fdt, "/cpus");
 	if (poffset < 0)
 		return;
 	fdt_for_each_subnode(doffset, fdt, poffset) {
@@ -210,10 +212,10 @@ void fdt_domain_fixup(void *fdt)
 skip_device_disable:
 
 	/* Remove the OpenSBI domain config DT node */
-	poffset = fdt_path_offset(fdt, "/chosen");
+	poffset = fdt_index_path_offset(fdt, "/chosen");
 	if (poffset < 0)
 		return;
-	poffset = fdt_node_offset_by_compatible(fdt, poffset,
+	poffset = fdt_index_node_offset_by_compatible(fdt, poffset,
 						"opensbi,domain,config");
 	if (poffset < 0)
 		return;
@@ -328,7 +330,7 @@ static int __fdt_parse_domain(void *fdt, int domain_offset, void *opaque)
 	len = len / sizeof(u32);
 	if (val && len) {
 		for (i = 0; i < len; i++) {
-			cpu_offset = fdt_node_offset_by_phandle(fdt,
+			cpu_offset = fdt_index_node_offset_by_phandle(fdt,
 							fdt32_to_cpu(val[i]));
 			if (cpu_offset < 0) {
 				err = cpu_offset;
@@ -378,7 +380,7 @@ static int __fdt_parse_domain(void *fdt, int domain_offset, void *opaque)
 	val32 = -1U;
 	val = fdt_getprop(fdt, domain_offset, "boot-hart", &len);
 	if (val && len >= 4) {
-		cpu_offset = fdt_node_offset_by_phandle(fdt,
+		cpu_offset = fdt_index_node_offset_by_phandle(fdt,
 							 fdt32_to_cpu(*val));
 		if (cpu_offset >= 0 && fdt_node_is_enabled(fdt, cpu_offset))
 			fdt_parse_hart_id(fdt, cpu_offset, &val32);
@@ -440,7 +442,7 @@ static int __fdt_parse_domain(void *fdt, int domain_offset, void *opaque)
 		dom->system_suspend_allowed = false;
 
 	/* Find /cpus DT node */
-	cpus_offset = fdt_path_offset(fdt, "/cpus");
+	cpus_offset = fdt_index_path_offset(fdt, "/cpus");
 	if (cpus_offset < 0) {
 		err = cpus_offset;
 		goto fail_free_all;
@@ -465,7 +467,8 @@ static int __fdt_parse_domain(void *fdt, int domain_offset, void *opaque)
 			goto fail_free_all;
 		}
 
-		doffset = fdt_node_offset_by_phandle(fdt, fdt32_to_cpu(*val));
+		doffset = fdt_index_node_offset_by_phandle(fdt,
+						fdt32_to_cpu(*val));
 		if (doffset < 0) {
 			err = doffset;
 			goto fail_free_all;
@@ -491,6 +494,57 @@ fail_free_domain:
 	return err;
 }
 
+static struct sbi_domain *fdt_domain_by_offset(void *fdt, int doffset)
+{
+	u32 i;
+	const char *name;
+	struct sbi_domain *dom;
+
+	name = fdt_get_name(fdt, doffset, NULL);
+	if (!name)
+		return NULL;
+
+	/* Domains are registered under their DT node name */
+	sbi_domain_for_each(i, dom) {
+		if (!strncmp(dom->name, name, sizeof(dom->name) - 1))
+			return dom;
+	}
+
+	return NULL;
+}
+
+static int __fdt_parse_domain_switch(void *fdt, int domain_offset,
+				     void *opaque)
+{
+	int i, len, doffset;
+	const u32 *val;
+	struct sbi_domain *dom, *from;
+
+	/* Read "switch-from" DT property */
+	val = fdt_getprop(fdt, domain_offset, "switch-from", &len);
+	if (!val || len < 4)
+		return 0;
+
+	dom = fdt_domain_by_offset(fdt, domain_offset);
+	if (!dom)
+		return SBI_EINVAL;
+
+	for (i = 0; i < len / 4; i++) {
+		doffset = fdt_index_node_offset_by_phandle(fdt,
+						fdt32_to_cpu(val[i]));
+		if (doffset < 0)
+			return doffset;
+
+		from = fdt_domain_by_offset(fdt, doffset);
+		if (!from)
+			return SBI_EINVAL;
+
+		sbi_domain_allow_switch(dom, from);
+	}
+
+	return 0;
+}
+
 int fdt_domains_populate(void *fdt)
 {
 	const u32 *val;
@@ -503,7 +557,7 @@ int fdt_domains_populate(void *fdt)
 		return SBI_EINVAL;
 
 	/* Find /cpus DT node */
-	cpus_offset = fdt_path_offset(fdt, "/cpus");
+	cpus_offset = fdt_index_path_offset(fdt, "/cpus");
 	if (cpus_offset < 0)
 		return cpus_offset;
 
@@ -523,13 +577,19 @@ int fdt_domains_populate(void *fdt)
 
 		val = fdt_getprop(fdt, cpu_offset, "opensbi-domain", &len);
 		if (val && len >= 4)
-			cold_domain_offset = fdt_node_offset_by_phandle(fdt,
-							   fdt32_to_cpu(*val));
+			cold_domain_offset =
+				fdt_index_node_offset_by_phandle(fdt,
+						fdt32_to_cpu(*val));
 
 		break;
 	}
 
 	/* Iterate over each domain in FDT and populate details */
-	return fdt_iterate_each_domain(fdt, &cold_domain_offset,
-				       __fdt_parse_domain);
+	err = fdt_iterate_each_domain(fdt, &cold_domain_offset,
+				      __fdt_parse_domain);
+	if (err)
+		return err;
+
+	/* Switches may be allowed from domains registered later */
+	return fdt_iterate_each_domain(fdt, NULL, __fdt_parse_domain_switch);
 }
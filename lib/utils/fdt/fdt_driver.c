@@ -0,0 +1,228 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * fdt_driver.c - Flat Device Tree driver matching by compatible hash
+ *
+ * Copyright (c) 2026 OpenSBI contributors.
+ */
+
+#include <libfdt.h>
+#include <sbi/riscv_barrier.h>
+#include <sbi/riscv_locks.h>
+#include <sbi/sbi_error.h>
+#include <sbi/sbi_heap.h>
+#include <sbi/sbi_string.h>
+#include <sbi_utils/fdt/fdt_driver.h>
+
+struct fdt_driver_slot {
+	u32 hash;
+	/* Position of the driver in the carray plus one, zero if unused */
+	u32 pos;
+	const struct fdt_match *match;
+};
+
+static spinlock_t fdt_driver_lock = SPIN_LOCK_INITIALIZER;
+
+static u32 fdt_driver_hash(const char *str)
+{
+	u32 hash = 2166136261U;
+
+	while (*str) {
+		hash ^= (u8)*str++;
+		hash *= 16777619U;
+	}
+
+	return hash;
+}
+
+static void fdt_driver_table_build(struct fdt_driver_table *table)
+{
+	unsigned long pos, i, n = 0, size = 16;
+	const struct fdt_match *match;
+	struct fdt_driver_slot *slots;
+	u32 hash;
+
+	for (pos = 0; pos < table->count; pos++) {
+		match = table->match_table(pos);
+		for (; match && match->compatible; match++)
+			n++;
+	}
+
+	/* Keep the load factor at or below one half */
+	while (size < 2 * n)
+		size <<= 1;
+
+	slots = sbi_calloc(size, sizeof(*slots));
+	if (!slots)
+		return;
+
+	/*
+	 * Entries are inserted in carray and match table order so that
+	 * probing for a compatible string finds them in that order too.
+	 */
+	for (pos = 0; pos < table->count; pos++) {
+		match = table->match_table(pos);
+		for (; match && match->compatible; match++) {
+			hash = fdt_driver_hash(match->compatible);
+			for (i = hash & (size - 1); slots[i].pos;
+			     i = (i + 1) & (size - 1))
+				;
+			slots[i].hash = hash;
+			slots[i].pos = pos + 1;
+			slots[i].match = match;
+		}
+	}
+
+	/* Readers check slots without the lock so publish it last */
+	table->slot_mask = size - 1;
+	__smp_store_release(&table->slots, slots);
+}
+
+static int fdt_driver_add_hit(struct fdt_driver_hit *hits, int count,
+			      int max_hits, unsigned long pos, int nodeoff,
+			      const struct fdt_match *match)
+{
+	int i, j;
+
+	for (i = 0; i < count; i++) {
+		if (hits[i].pos == pos) {
+			/* Prefer the earliest entry of the match table */
+			if (match < hits[i].match)
+				hits[i].match = match;
+			return count;
+		}
+		if (hits[i].pos > pos)
+			break;
+	}
+
+	if (count >= max_hits)
+		return count;
+
+	for (j = count; j > i; j--)
+		hits[j] = hits[j - 1];
+	hits[i].pos = pos;
+	hits[i].nodeoff = nodeoff;
+	hits[i].match = match;
+
+	return count + 1;
+}
+
+int fdt_driver_match_node(void *fdt, int nodeoff,
+			  struct fdt_driver_table *table,
+			  struct fdt_driver_hit *hits, int max_hits)
+{
+	int len, slen, count = 0;
+	struct fdt_driver_slot *slots, *slot;
+	const struct fdt_match *match;
+	const char *compat;
+	unsigned long pos, i;
+	u32 hash;
+
+	if (!fdt || nodeoff < 0 || !table || !hits || max_hits <= 0)
+		return SBI_EINVAL;
+
+	slots = __smp_load_acquire(&table->slots);
+	if (!slots) {
+		spin_lock(&fdt_driver_lock);
+		if (!table->slots)
+			fdt_driver_table_build(table);
+		slots = table->slots;
+		spin_unlock(&fdt_driver_lock);
+	}
+
+	/* Without the hash match the node driver by driver */
+	if (!slots) {
+		for (pos = 0; pos < table->count; pos++) {
+			match = fdt_match_node(fdt, nodeoff,
+					       table->match_table(pos));
+			if (match)
+				count = fdt_driver_add_hit(hits, count,
+							   max_hits, pos,
+							   nodeoff, match);
+		}
+		return count;
+	}
+
+	compat = fdt_getprop(fdt, nodeoff, "compatible", &len);
+	while (compat && len > 0) {
+		slen = sbi_strnlen(compat, len) + 1;
+		if (slen > len)
+			break;
+
+		hash = fdt_driver_hash(compat);
+		for (i = hash & table->slot_mask; slots[i].pos;
+		     i = (i + 1) & table->slot_mask) {
+			slot = &slots[i];
+			if (slot->hash != hash ||
+			    sbi_strcmp(slot->match->compatible, compat))
+				continue;
+			count = fdt_driver_add_hit(hits, count, max_hits,
+						   slot->pos - 1, nodeoff,
+						   slot->match);
+		}
+
+		compat += slen;
+		len -= slen;
+	}
+
+	return count;
+}
+
+int fdt_driver_scan(void *fdt, struct fdt_driver_table *table,
+		    struct fdt_driver_hit **out_hits)
+{
+	struct fdt_driver_hit node_hits[FDT_DRIVER_MAX_NODE_HITS];
+	struct fdt_driver_hit *hits = NULL, *tmp, hit;
+	int i, j, rc, off, depth = 0, count = 0, size = 0;
+
+	if (!out_hits)
+		return SBI_EINVAL;
+	*out_hits = NULL;
+	if (!fdt || !table)
+		return SBI_EINVAL;
+
+	for (off = fdt_next_node(fdt, -1, &depth); off >= 0;
+	     off = fdt_next_node(fdt, off, &depth)) {
+		rc = fdt_driver_match_node(fdt, off, table, node_hits,
+					   array_size(node_hits));
+		if (rc < 0)
+			goto fail;
+		if (!rc)
+			continue;
+
+		if (count + rc > size) {
+			size = size ? 2 * size : 16;
+			tmp = sbi_calloc(size, sizeof(*tmp));
+			if (!tmp) {
+				rc = SBI_ENOMEM;
+				goto fail;
+			}
+			if (hits) {
+				sbi_memcpy(tmp, hits, count * sizeof(*hits));
+				sbi_free(hits);
+			}
+			hits = tmp;
+		}
+
+		sbi_memcpy(&hits[count], node_hits, rc * sizeof(*hits));
+		count += rc;
+	}
+	if (off != -FDT_ERR_NOTFOUND) {
+		rc = SBI_EINVAL;
+		goto fail;
+	}
+
+	/* Nodes were walked in offset order so a stable sort is enough */
+	for (i = 1; i < count; i++) {
+		hit = hits[i];
+		for (j = i; j > 0 && hits[j - 1].pos > hit.pos; j--)
+			hits[j] = hits[j - 1];
+		hits[j] = hit;
+	}
+
+	*out_hits = hits;
+	return count;
+
+fail:
+	sbi_free(hits);
+	return rc;
+}
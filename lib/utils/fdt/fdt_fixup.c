@@ -19,6 +19,7 @@
 #include <sbi_utils/fdt/fdt_fixup.h>
 #include <sbi_utils/fdt/fdt_pmu.h>
 #include <sbi_utils/fdt/fdt_helper.h>
+#include <sbi_utils/fdt/fdt_index.h>
 
 int fdt_add_cpu_idle_states(void *fdt, const struct sbi_cpu_idle_state *state)
 {
@@ -28,6 +29,7 @@ int fdt_add_cpu_idle_states(void *fdt, const struct sbi_cpu_idle_state *state)
 	err = fdt_open_into(fdt, fdt, fdt_totalsize(fdt) + 1024);
 	if (err < 0)
 		return err;
+	fdt_index_invalidate();
 
 	err = fdt_find_max_phandle(fdt, &phandle);
 	phandle++;
@@ -105,95 +107,385 @@ int fdt_add_cpu_idle_states(void *fdt, const struct sbi_cpu_idle_state *state)
 	return 0;
 }
 
-void fdt_cpu_fixup(void *fdt)
+#define FDT_FIXUP_TAGALIGN(x)	(((x) + FDT_TAGSIZE - 1) & ~(FDT_TAGSIZE - 1))
+
+/* Size of a "status" = "disabled" property in the structure block */
+#define FDT_FIXUP_STATUS_SIZE		\
+	(sizeof(struct fdt_property) + FDT_FIXUP_TAGALIGN(sizeof("disabled")))
+
+/* Maximum node depth for which parent path handlers are matched */
+#define FDT_FIXUP_MAX_DEPTH		32
+
+static int fdt_fixup_queue(struct fdt_fixup_pass *pass, int nodeoff,
+			   const char *prop)
 {
-	struct sbi_domain *dom = sbi_domain_thishart_ptr();
-	int err, cpu_offset, cpus_offset, len;
-	const char *mmu_type;
-	u32 hartid;
+	struct fdt_fixup_edit *edit;
+
+	if (pass->count >= FDT_FIXUP_MAX_EDITS) {
+		sbi_printf("%s: Too many edits queued, %s of %s dropped\n",
+			   __func__, prop ? prop : "status",
+			   fdt_get_name(pass->fdt, nodeoff, NULL));
+		if (!pass->err)
+			pass->err = SBI_ENOSPC;
+		return SBI_ENOSPC;
+	}
 
-	err = fdt_open_into(fdt, fdt, fdt_totalsize(fdt) + 32);
-	if (err < 0)
-		return;
+	edit = &pass->edits[pass->count++];
+	edit->nodeoff = nodeoff;
+	edit->prop = prop;
 
-	cpus_offset = fdt_path_offset(fdt, "/cpus");
-	if (cpus_offset < 0)
-		return;
+	return 0;
+}
+
+int fdt_fixup_disable(struct fdt_fixup_pass *pass, int nodeoff)
+{
+	return fdt_fixup_queue(pass, nodeoff, NULL);
+}
+
+int fdt_fixup_delprop(struct fdt_fixup_pass *pass, int nodeoff,
+		      const char *prop)
+{
+	if (!prop)
+		return SBI_EINVAL;
+
+	return fdt_fixup_queue(pass, nodeoff, prop);
+}
+
+/* Range of the structure block replaced by a queued edit */
+struct fdt_fixup_splice {
+	/* Offset of the range in the structure block */
+	int off;
+	/* Number of bytes removed */
+	int len;
+	/* Write a "status" = "disabled" property in place of the range */
+	bool status;
+};
+
+/* Find a property of a node and its size in the structure block */
+static int fdt_fixup_find_prop(void *fdt, int nodeoff, const char *name,
+			       int *size)
+{
+	const char *pname;
+	int prop, len;
+
+	fdt_for_each_property_offset(prop, fdt, nodeoff) {
+		if (!fdt_getprop_by_offset(fdt, prop, &pname, &len))
+			return len;
+		if (!strcmp(pname, name)) {
+			*size = sizeof(struct fdt_property) +
+				FDT_FIXUP_TAGALIGN(len);
+			return prop;
+		}
+	}
+
+	return prop;
+}
+
+/* Find a string in the strings block, or -1 if it is not there */
+static int fdt_fixup_find_string(void *fdt, const char *str)
+{
+	const char *strtab = (const char *)fdt + fdt_off_dt_strings(fdt);
+	int i, len = strlen(str) + 1, size = fdt_size_dt_strings(fdt);
+
+	for (i = 0; i + len <= size; i++) {
+		if (!memcmp(strtab + i, str, len))
+			return i;
+	}
+
+	return -1;
+}
 
-	fdt_for_each_subnode(cpu_offset, fdt, cpus_offset) {
-		err = fdt_parse_hart_id(fdt, cpu_offset, &hartid);
-		if (err)
+/*
+ * Turn the queued edits into ranges of the structure block sorted by
+ * offset. Edits of a missing property and edits overlapping an earlier
+ * one, such as the same node disabled twice, are dropped.
+ */
+static int fdt_fixup_splices(struct fdt_fixup_pass *pass,
+			     struct fdt_fixup_splice *splices)
+{
+	struct fdt_fixup_edit *edit;
+	struct fdt_fixup_splice sp, *prev;
+	void *fdt = pass->fdt;
+	int i, j, off, size, count = 0;
+
+	for (i = 0; i < pass->count; i++) {
+		edit = &pass->edits[i];
+		off = fdt_fixup_find_prop(fdt, edit->nodeoff,
+					  edit->prop ? edit->prop : "status",
+					  &size);
+		if (off >= 0) {
+			sp.off = off;
+			sp.len = size;
+		} else if (off == -FDT_ERR_NOTFOUND && !edit->prop) {
+			/* New properties go right after the node name */
+			if (fdt_next_tag(fdt, edit->nodeoff, &sp.off) !=
+			    FDT_BEGIN_NODE)
+				return -FDT_ERR_BADOFFSET;
+			sp.len = 0;
+		} else if (off == -FDT_ERR_NOTFOUND) {
 			continue;
+		} else {
+			return off;
+		}
+		sp.status = !edit->prop;
 
-		if (!fdt_node_is_enabled(fdt, cpu_offset))
+		/* Insertions sort before removals at the same offset */
+		for (j = count; j > 0; j--) {
+			prev = &splices[j - 1];
+			if (prev->off < sp.off ||
+			    (prev->off == sp.off && (!prev->len || sp.len)))
+				break;
+			splices[j] = *prev;
+		}
+		splices[j] = sp;
+		count++;
+	}
+
+	for (i = j = 0; i < count; i++) {
+		prev = j ? &splices[j - 1] : NULL;
+		if (prev && (splices[i].off < prev->off + prev->len ||
+			     (splices[i].off == prev->off && !prev->len &&
+			      !splices[i].len)))
 			continue;
+		splices[j++] = splices[i];
+	}
 
+	return j;
+}
+
+/*
+ * Apply the queued edits in one pass over the structure block. The
+ * change in size of the structure block is returned in delta.
+ *
+ * Applying each edit with libfdt moves the tail of the blob once per
+ * edit. Instead, the structure and strings blocks are moved up once by
+ * the largest growth seen while walking the edits and then copied back
+ * down, rewriting the edited ranges on the way.
+ */
+static int fdt_fixup_flush(struct fdt_fixup_pass *pass, int *delta)
+{
+	struct fdt_fixup_splice splices[FDT_FIXUP_MAX_EDITS];
+	struct fdt_property *status;
+	void *fdt = pass->fdt;
+	int i, err, count, nameoff = -1, space = 0;
+	int grow = 0, rd, wr, len, tail;
+	bool new_string = false;
+	char *base;
+
+	*delta = 0;
+	if (!pass->count)
+		return 0;
+
+	/* Deleting a property only shrinks the blob */
+	for (i = 0; i < pass->count; i++) {
+		if (!pass->edits[i].prop)
+			space += FDT_FIXUP_STATUS_SIZE;
+	}
+	if (space)
+		space += sizeof("status");
+
+	err = fdt_open_into(fdt, fdt, fdt_totalsize(fdt) + space);
+	if (err < 0)
+		return err;
+	fdt_index_invalidate();
+
+	count = fdt_fixup_splices(pass, splices);
+	pass->count = 0;
+	if (count <= 0)
+		return count;
+
+	for (i = 0; i < count; i++) {
+		if (splices[i].status && nameoff < 0) {
+			nameoff = fdt_fixup_find_string(fdt, "status");
+			if (nameoff < 0) {
+				nameoff = fdt_size_dt_strings(fdt);
+				new_string = true;
+			}
+		}
+		*delta += (splices[i].status ? FDT_FIXUP_STATUS_SIZE : 0) -
+			  splices[i].len;
+		if (grow < *delta)
+			grow = *delta;
+	}
+
+	base = (char *)fdt + fdt_off_dt_struct(fdt);
+	tail = fdt_size_dt_struct(fdt) + fdt_size_dt_strings(fdt);
+	if (grow)
+		memmove(base + grow, base, tail);
+
+	/* Writes never overtake reads since grow covers every prefix */
+	for (rd = grow, wr = 0, i = 0; i < count; i++) {
+		len = grow + splices[i].off - rd;
+		memmove(base + wr, base + rd, len);
+		rd += len + splices[i].len;
+		wr += len;
+		if (!splices[i].status)
+			continue;
+
+		status = (void *)(base + wr);
+		status->tag = cpu_to_fdt32(FDT_PROP);
+		status->len = cpu_to_fdt32(sizeof("disabled"));
+		status->nameoff = cpu_to_fdt32(nameoff);
+		memset(status->data, 0, FDT_FIXUP_STATUS_SIZE -
+					 sizeof(struct fdt_property));
+		memcpy(status->data, "disabled", sizeof("disabled"));
+		wr += FDT_FIXUP_STATUS_SIZE;
+	}
+	memmove(base + wr, base + rd, grow + tail - rd);
+
+	fdt_set_size_dt_struct(fdt, fdt_size_dt_struct(fdt) + *delta);
+	fdt_set_off_dt_strings(fdt, fdt_off_dt_strings(fdt) + *delta);
+	if (new_string) {
+		memcpy((char *)fdt + fdt_off_dt_strings(fdt) + nameoff,
+		       "status", sizeof("status"));
+		fdt_set_size_dt_strings(fdt, nameoff + sizeof("status"));
+	}
+
+	return 0;
+}
+
+static void fdt_fixup_resolve_paths(void *fdt,
+				    const struct fdt_fixup_handler *handlers,
+				    int count, int *path_off)
+{
+	int i;
+
+	for (i = 0; i < count; i++)
+		path_off[i] = handlers[i].parent_path ?
+			fdt_path_offset(fdt, handlers[i].parent_path) : -1;
+}
+
+int fdt_fixup_run(void *fdt, const struct fdt_fixup_handler *handlers,
+		  int count)
+{
+	const struct fdt_fixup_handler *h;
+	struct fdt_fixup_pass pass = { .fdt = fdt };
+	int path_off[FDT_FIXUP_MAX_HANDLERS];
+	int parents[FDT_FIXUP_MAX_DEPTH];
+	int i, rc, off, delta, depth = -1, parent;
+
+	if (!fdt || !handlers || count > FDT_FIXUP_MAX_HANDLERS)
+		return SBI_EINVAL;
+
+	fdt_fixup_resolve_paths(fdt, handlers, count, path_off);
+
+	for (off = fdt_next_node(fdt, -1, &depth); off >= 0;
+	     off = fdt_next_node(fdt, off, &depth)) {
 		/*
-		 * Disable a HART DT node if one of the following is true:
-		 * 1. The HART is not assigned to the current domain
-		 * 2. MMU is not available for the HART
+		 * All queued edits are in nodes before the current one
+		 * so after applying them only the offsets need fixing.
 		 */
+		if (pass.count > FDT_FIXUP_MAX_EDITS - FDT_FIXUP_NODE_EDITS) {
+			rc = fdt_fixup_flush(&pass, &delta);
+			if (rc)
+				return rc;
+			off += delta;
+			fdt_fixup_resolve_paths(fdt, handlers, count, path_off);
+			for (i = 0; i < depth && i < FDT_FIXUP_MAX_DEPTH; i++)
+				parents[i] = fdt_supernode_atdepth_offset(fdt,
+								off, i, NULL);
+		}
 
-		mmu_type = fdt_getprop(fdt, cpu_offset, "mmu-type", &len);
-		if (!sbi_domain_is_assigned_hart(dom, hartid) ||
-		    !mmu_type || !len)
-			fdt_setprop_string(fdt, cpu_offset, "status",
-					   "disabled");
+		if (depth < FDT_FIXUP_MAX_DEPTH)
+			parents[depth] = off;
+		parent = (depth > 0 && depth <= FDT_FIXUP_MAX_DEPTH) ?
+			 parents[depth - 1] : -1;
+
+		for (i = 0; i < count; i++) {
+			h = &handlers[i];
+			if (h->parent_path &&
+			    (path_off[i] < 0 || path_off[i] != parent))
+				continue;
+			if (h->compatible &&
+			    fdt_node_check_compatible(fdt, off, h->compatible))
+				continue;
+			h->fixup(&pass, off);
+		}
 	}
+
+	rc = fdt_fixup_flush(&pass, &delta);
+
+	return rc ? rc : pass.err;
 }
 
-static void fdt_domain_based_fixup_one(void *fdt, int nodeoff)
+static void fdt_cpu_fixup_one(struct fdt_fixup_pass *pass, int cpu_offset)
+{
+	struct sbi_domain *dom = sbi_domain_thishart_ptr();
+	void *fdt = pass->fdt;
+	const char *mmu_type;
+	int err, len;
+	u32 hartid;
+
+	err = fdt_parse_hart_id(fdt, cpu_offset, &hartid);
+	if (err)
+		return;
+
+	if (!fdt_node_is_enabled(fdt, cpu_offset))
+		return;
+
+	/*
+	 * Disable a HART DT node if one of the following is true:
+	 * 1. The HART is not assigned to the current domain
+	 * 2. MMU is not available for the HART
+	 */
+
+	mmu_type = fdt_getprop(fdt, cpu_offset, "mmu-type", &len);
+	if (!sbi_domain_is_assigned_hart(dom, hartid) ||
+	    !mmu_type || !len)
+		fdt_fixup_disable(pass, cpu_offset);
+}
+
+static const struct fdt_fixup_handler fdt_cpu_fixups[] = {
+	{ .parent_path = "/cpus", .fixup = fdt_cpu_fixup_one },
+};
+
+void fdt_cpu_fixup(void *fdt)
+{
+	fdt_fixup_run(fdt, fdt_cpu_fixups, array_size(fdt_cpu_fixups));
+}
+
+static void fdt_domain_based_fixup_one(struct fdt_fixup_pass *pass,
+				       int nodeoff)
 {
 	int rc;
 	uint64_t reg_addr, reg_size;
 	struct sbi_domain *dom = sbi_domain_thishart_ptr();
 
-	rc = fdt_get_node_addr_size(fdt, nodeoff, 0, &reg_addr, &reg_size);
+	rc = fdt_get_node_addr_size(pass->fdt, nodeoff, 0,
+				    &reg_addr, &reg_size);
 	if (rc < 0 || !reg_addr || !reg_size)
 		return;
 
 	if (!sbi_domain_check_addr(dom, reg_addr, dom->next_mode,
-				    SBI_DOMAIN_READ | SBI_DOMAIN_WRITE)) {
-		rc = fdt_open_into(fdt, fdt, fdt_totalsize(fdt) + 32);
-		if (rc < 0)
-			return;
-		fdt_setprop_string(fdt, nodeoff, "status", "disabled");
-	}
+				    SBI_DOMAIN_READ | SBI_DOMAIN_WRITE))
+		fdt_fixup_disable(pass, nodeoff);
 }
 
-static void fdt_fixup_node(void *fdt, const char *compatible)
-{
-	int noff = 0;
-
-	while ((noff = fdt_node_offset_by_compatible(fdt, noff,
-						     compatible)) >= 0)
-		fdt_domain_based_fixup_one(fdt, noff);
-}
+static const struct fdt_fixup_handler fdt_aplic_fixups[] = {
+	{ .compatible = "riscv,aplic", .fixup = fdt_domain_based_fixup_one },
+};
 
 void fdt_aplic_fixup(void *fdt)
 {
-	fdt_fixup_node(fdt, "riscv,aplic");
+	fdt_fixup_run(fdt, fdt_aplic_fixups, array_size(fdt_aplic_fixups));
 }
 
+static const struct fdt_fixup_handler fdt_imsic_fixups[] = {
+	{ .compatible = "riscv,imsics", .fixup = fdt_domain_based_fixup_one },
+};
+
 void fdt_imsic_fixup(void *fdt)
 {
-	fdt_fixup_node(fdt, "riscv,imsics");
+	fdt_fixup_run(fdt, fdt_imsic_fixups, array_size(fdt_imsic_fixups));
 }
 
-void fdt_plic_fixup(void *fdt)
+static void fdt_plic_fixup_one(struct fdt_fixup_pass *pass, int plic_off)
 {
 	u32 *cells;
 	int i, cells_count;
-	int plic_off;
-
-	plic_off = fdt_node_offset_by_compatible(fdt, 0, "sifive,plic-1.0.0");
-	if (plic_off < 0) {
-		plic_off = fdt_node_offset_by_compatible(fdt, 0, "riscv,plic0");
-		if (plic_off < 0)
-			return;
-	}
 
-	cells = (u32 *)fdt_getprop(fdt, plic_off,
+	/* Updated in place so there is nothing to queue */
+	cells = (u32 *)fdt_getprop(pass->fdt, plic_off,
 				   "interrupts-extended", &cells_count);
 	if (!cells)
 		return;
@@ -208,6 +500,16 @@ void fdt_plic_fixup(void *fdt)
 	}
 }
 
+static const struct fdt_fixup_handler fdt_plic_fixups[] = {
+	{ .compatible = "sifive,plic-1.0.0", .fixup = fdt_plic_fixup_one },
+	{ .compatible = "riscv,plic0", .fixup = fdt_plic_fixup_one },
+};
+
+void fdt_plic_fixup(void *fdt)
+{
+	fdt_fixup_run(fdt, fdt_plic_fixups, array_size(fdt_plic_fixups));
+}
+
 static int fdt_resv_memory_update_node(void *fdt, unsigned long addr,
 				       unsigned long size, int index,
 				       int parent)
@@ -301,6 +603,7 @@ int fdt_reserved_memory_fixup(void *fdt)
 	err = fdt_open_into(fdt, fdt, fdt_totalsize(fdt) + 1024);
 	if (err < 0)
 		return err;
+	fdt_index_invalidate();
 
 	/* try to locate the reserved memory node */
 	parent = fdt_path_offset(fdt, "/reserved-memory");
@@ -385,17 +688,27 @@ int fdt_reserved_memory_fixup(void *fdt)
 	return 0;
 }
 
-void fdt_fixups(void *fdt)
-{
-	fdt_aplic_fixup(fdt);
+static const struct fdt_fixup_handler fdt_default_fixups[] = {
+	{ .parent_path = "/cpus", .fixup = fdt_cpu_fixup_one },
+	{ .compatible = "riscv,aplic", .fixup = fdt_domain_based_fixup_one },
+	{ .compatible = "riscv,imsics", .fixup = fdt_domain_based_fixup_one },
+	{ .compatible = "sifive,plic-1.0.0", .fixup = fdt_plic_fixup_one },
+	{ .compatible = "riscv,plic0", .fixup = fdt_plic_fixup_one },
+#if defined(CONFIG_FDT_PMU) && !defined(CONFIG_FDT_FIXUPS_PRESERVE_PMU_NODE)
+	{ .compatible = "riscv,pmu", .fixup = fdt_pmu_fixup_node },
+#endif
+};
 
-	fdt_imsic_fixup(fdt);
+int fdt_fixups(void *fdt)
+{
+	int rc;
 
-	fdt_plic_fixup(fdt);
+	rc = fdt_fixup_run(fdt, fdt_default_fixups,
+			   array_size(fdt_default_fixups));
+	if (rc)
+		return rc;
 
 	fdt_reserved_memory_fixup(fdt);
 
-#ifndef CONFIG_FDT_FIXUPS_PRESERVE_PMU_NODE
-	fdt_pmu_fixup(fdt);
-#endif
+	return 0;
 }
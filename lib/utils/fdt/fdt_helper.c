@@ -10,10 +10,12 @@
 #include <sbi/riscv_asm.h>
 #include <sbi/sbi_console.h>
 #include <sbi/sbi_hartmask.h>
+#include <sbi/sbi_idle.h>
 #include <sbi/sbi_platform.h>
 #include <sbi/sbi_scratch.h>
 #include <sbi/sbi_hart.h>
 #include <sbi_utils/fdt/fdt_helper.h>
+#include <sbi_utils/fdt/fdt_index.h>
 #include <sbi_utils/irqchip/aplic.h>
 #include <sbi_utils/irqchip/imsic.h>
 #include <sbi_utils/irqchip/plic.h>
@@ -23,6 +25,7 @@
 #define DEFAULT_UART_REG_SHIFT		0
 #define DEFAULT_UART_REG_IO_WIDTH	1
 #define DEFAULT_UART_REG_OFFSET		0
+#define DEFAULT_UART_FIFO_SIZE		0
 
 #define DEFAULT_RENESAS_SCIF_FREQ		100000000
 #define DEFAULT_RENESAS_SCIF_BAUD		115200
@@ -62,7 +65,7 @@ int fdt_find_match(void *fdt, int startoff,
 		return SBI_ENODEV;
 
 	while (match_table->compatible) {
-		nodeoff = fdt_node_offset_by_compatible(fdt, startoff,
+		nodeoff = fdt_index_node_offset_by_compatible(fdt, startoff,
 						match_table->compatible);
 		if (nodeoff >= 0) {
 			if (out_match)
@@ -92,7 +95,7 @@ int fdt_parse_phandle_with_args(void *fdt, int nodeoff,
 	list_end = list + (len / sizeof(*list));
 
 	while (list < list_end) {
-		pnodeoff = fdt_node_offset_by_phandle(fdt,
+		pnodeoff = fdt_index_node_offset_by_phandle(fdt,
 						fdt32_to_cpu(*list));
 		if (pnodeoff < 0)
 			return pnodeoff;
@@ -300,7 +303,7 @@ int fdt_parse_max_enabled_hart_id(void *fdt, u32 *max_hartid)
 
 	*max_hartid = 0;
 
-	cpus_offset = fdt_path_offset(fdt, "/cpus");
+	cpus_offset = fdt_index_path_offset(fdt, "/cpus");
 	if (cpus_offset < 0)
 		return cpus_offset;
 
@@ -327,7 +330,7 @@ int fdt_parse_timebase_frequency(void *fdt, unsigned long *freq)
 	if (!fdt || !freq)
 		return SBI_EINVAL;
 
-	cpus_offset = fdt_path_offset(fdt, "/cpus");
+	cpus_offset = fdt_index_path_offset(fdt, "/cpus");
 	if (cpus_offset < 0)
 		return cpus_offset;
 
@@ -340,6 +343,48 @@ int fdt_parse_timebase_frequency(void *fdt, unsigned long *freq)
 	return 0;
 }
 
+int fdt_parse_idle_states(void *fdt)
+{
+	struct sbi_idle_state state;
+	const fdt32_t *val;
+	int len, rc, idle_offset, state_offset;
+
+	if (!fdt)
+		return SBI_EINVAL;
+
+	idle_offset = fdt_path_offset(fdt, "/cpus/idle-states");
+	if (idle_offset < 0)
+		return 0;
+
+	fdt_for_each_subnode(state_offset, fdt, idle_offset) {
+		if (fdt_node_check_compatible(fdt, state_offset,
+					      "riscv,idle-state"))
+			continue;
+		if (!fdt_node_is_enabled(fdt, state_offset))
+			continue;
+
+		val = fdt_getprop(fdt, state_offset,
+				  "riscv,sbi-suspend-param", &len);
+		if (!val || len < sizeof(fdt32_t))
+			continue;
+		state.suspend_type = fdt32_to_cpu(*val);
+
+		val = fdt_getprop(fdt, state_offset, "exit-latency-us", &len);
+		state.exit_latency_us = (val && len >= sizeof(fdt32_t)) ?
+					fdt32_to_cpu(*val) : 0;
+
+		val = fdt_getprop(fdt, state_offset, "min-residency-us", &len);
+		state.min_residency_us = (val && len >= sizeof(fdt32_t)) ?
+					 fdt32_to_cpu(*val) : 0;
+
+		rc = sbi_idle_state_register(&state);
+		if (rc && rc != SBI_EALREADY)
+			return rc;
+	}
+
+	return 0;
+}
+
 #define RISCV_ISA_EXT_NAME_LEN_MAX	32
 
 static unsigned long fdt_isa_bitmap_offset;
@@ -422,7 +467,7 @@ static int fdt_parse_isa_all_harts(void *fdt)
 	if (!fdt || !fdt_isa_bitmap_offset)
 		return SBI_EINVAL;
 
-	cpus_offset = fdt_path_offset(fdt, "/cpus");
+	cpus_offset = fdt_index_path_offset(fdt, "/cpus");
 	if (cpus_offset < 0)
 		return cpus_offset;
 
@@ -582,6 +627,12 @@ int fdt_parse_uart_node(void *fdt, int nodeoffset,
 	else
 		uart->reg_offset = DEFAULT_UART_REG_OFFSET;
 
+	val = (fdt32_t *)fdt_getprop(fdt, nodeoffset, "fifo-size", &len);
+	if (len > 0 && val)
+		uart->fifo_size = fdt32_to_cpu(*val);
+	else
+		uart->fifo_size = DEFAULT_UART_FIFO_SIZE;
+
 	return 0;
 }
 
@@ -593,7 +644,7 @@ int fdt_parse_uart8250(void *fdt, struct platform_uart_data *uart,
 	if (!compatible || !uart || !fdt)
 		return SBI_ENODEV;
 
-	nodeoffset = fdt_node_offset_by_compatible(fdt, -1, compatible);
+	nodeoffset = fdt_index_node_offset_by_compatible(fdt, -1, compatible);
 	if (nodeoffset < 0)
 		return nodeoffset;
 
@@ -645,7 +696,8 @@ int fdt_parse_aplic_node(void *fdt, int nodeoff, struct aplic_data *aplic)
 
 	val = fdt_getprop(fdt, nodeoff, "msi-parent", &len);
 	if (val && len >= sizeof(fdt32_t)) {
-		noff = fdt_node_offset_by_phandle(fdt, fdt32_to_cpu(*val));
+		noff = fdt_index_node_offset_by_phandle(fdt,
+						fdt32_to_cpu(*val));
 		if (noff < 0)
 			return noff;
 
@@ -678,7 +730,8 @@ int fdt_parse_aplic_node(void *fdt, int nodeoff, struct aplic_data *aplic)
 		if (!val || len < sizeof(fdt32_t))
 			goto aplic_msi_parent_done;
 
-		noff = fdt_node_offset_by_phandle(fdt, fdt32_to_cpu(*val));
+		noff = fdt_index_node_offset_by_phandle(fdt,
+						fdt32_to_cpu(*val));
 		if (noff < 0)
 			return noff;
 
@@ -686,7 +739,8 @@ int fdt_parse_aplic_node(void *fdt, int nodeoff, struct aplic_data *aplic)
 		if (!val || len < sizeof(fdt32_t))
 			goto aplic_msi_parent_done;
 
-		noff = fdt_node_offset_by_phandle(fdt, fdt32_to_cpu(*val));
+		noff = fdt_index_node_offset_by_phandle(fdt,
+						fdt32_to_cpu(*val));
 		if (noff < 0)
 			return noff;
 
@@ -772,7 +826,7 @@ bool fdt_check_imsic_mlevel(void *fdt)
 	if (!fdt)
 		return false;
 
-	while ((noff = fdt_node_offset_by_compatible(fdt, noff,
+	while ((noff = fdt_index_node_offset_by_compatible(fdt, noff,
 						     "riscv,imsics")) >= 0) {
 		val = fdt_getprop(fdt, noff, "interrupts-extended", &len);
 		if (val && len > sizeof(fdt32_t)) {
@@ -896,7 +950,7 @@ int fdt_parse_plic(void *fdt, struct plic_data *plic, const char *compat)
 	if (!compat || !plic || !fdt)
 		return SBI_ENODEV;
 
-	nodeoffset = fdt_node_offset_by_compatible(fdt, -1, compat);
+	nodeoffset = fdt_index_node_offset_by_compatible(fdt, -1, compat);
 	if (nodeoffset < 0)
 		return nodeoffset;
 
@@ -999,7 +1053,8 @@ int fdt_parse_aclint_node(void *fdt, int nodeoffset,
 		phandle = fdt32_to_cpu(val[2 * i]);
 		hwirq = fdt32_to_cpu(val[(2 * i) + 1]);
 
-		cpu_intc_offset = fdt_node_offset_by_phandle(fdt, phandle);
+		cpu_intc_offset = fdt_index_node_offset_by_phandle(fdt,
+						phandle);
 		if (cpu_intc_offset < 0)
 			continue;
 
@@ -1063,7 +1118,8 @@ int fdt_parse_plmt_node(void *fdt, int nodeoffset, unsigned long *plmt_base,
 		phandle = fdt32_to_cpu(val[2 * i]);
 		hwirq = fdt32_to_cpu(val[2 * i + 1]);
 
-		cpu_intc_offset = fdt_node_offset_by_phandle(fdt, phandle);
+		cpu_intc_offset = fdt_index_node_offset_by_phandle(fdt,
+						phandle);
 		if (cpu_intc_offset < 0)
 			continue;
 
@@ -1119,7 +1175,8 @@ int fdt_parse_plicsw_node(void *fdt, int nodeoffset, unsigned long *plicsw_base,
 		phandle = fdt32_to_cpu(val[2 * i]);
 		hwirq = fdt32_to_cpu(val[2 * i + 1]);
 
-		cpu_intc_offset = fdt_node_offset_by_phandle(fdt, phandle);
+		cpu_intc_offset = fdt_index_node_offset_by_phandle(fdt,
+						phandle);
 		if (cpu_intc_offset < 0)
 			continue;
 
@@ -1149,7 +1206,7 @@ int fdt_parse_compat_addr(void *fdt, uint64_t *addr,
 {
 	int nodeoffset, rc;
 
-	nodeoffset = fdt_node_offset_by_compatible(fdt, -1, compatible);
+	nodeoffset = fdt_index_node_offset_by_compatible(fdt, -1, compatible);
 	if (nodeoffset < 0)
 		return nodeoffset;
 
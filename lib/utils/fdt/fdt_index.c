@@ -0,0 +1,245 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * fdt_index.c - Flat Device Tree phandle, compatible and path index
+ *
+ * Copyright (c) 2026 OpenSBI contributors.
+ */
+
+#include <libfdt.h>
+#include <sbi/riscv_barrier.h>
+#include <sbi/riscv_locks.h>
+#include <sbi/sbi_string.h>
+#include <sbi_utils/fdt/fdt_index.h>
+
+#define FDT_INDEX_PATHS		8
+#define FDT_INDEX_PATH_LEN	64
+
+#define FDT_INDEX_KEY(hi, off)	(((u64)(hi) << 32) | (u32)(off))
+#define FDT_INDEX_KEY_HI(key)	((u32)((key) >> 32))
+#define FDT_INDEX_KEY_OFF(key)	((int)(u32)(key))
+
+struct fdt_index_path {
+	u32 hash;
+	int offset;
+	char path[FDT_INDEX_PATH_LEN];
+};
+
+/*
+ * Keys are sorted (phandle, offset) and (hash of compatible string,
+ * offset) pairs so that a lookup is a binary search followed by a
+ * short walk over nodes sharing the same phandle or compatible hash.
+ */
+static u64 phandle_keys[CONFIG_FDT_INDEX_ENTRIES];
+static u64 compat_keys[CONFIG_FDT_INDEX_ENTRIES];
+static int phandle_count, compat_count;
+
+static struct fdt_index_path path_cache[FDT_INDEX_PATHS];
+static int path_count;
+static spinlock_t path_lock = SPIN_LOCK_INITIALIZER;
+
+/* Structure and strings block sizes the index was built for */
+static bool index_valid;
+static u32 index_struct_size, index_strings_size;
+
+static u32 fdt_index_hash(const char *str, int len)
+{
+	u32 hash = 2166136261U;
+
+	while (len-- > 0 && *str) {
+		hash ^= (u8)*str++;
+		hash *= 16777619U;
+	}
+
+	return hash;
+}
+
+static void fdt_index_sift(u64 *keys, int root, int count)
+{
+	int child;
+	u64 tmp;
+
+	while ((child = 2 * root + 1) < count) {
+		if (child + 1 < count && keys[child] < keys[child + 1])
+			child++;
+		if (keys[root] >= keys[child])
+			return;
+		tmp = keys[root];
+		keys[root] = keys[child];
+		keys[child] = tmp;
+		root = child;
+	}
+}
+
+static void fdt_index_sort(u64 *keys, int count)
+{
+	int i;
+	u64 tmp;
+
+	for (i = count / 2 - 1; i >= 0; i--)
+		fdt_index_sift(keys, i, count);
+
+	for (i = count - 1; i > 0; i--) {
+		tmp = keys[0];
+		keys[0] = keys[i];
+		keys[i] = tmp;
+		fdt_index_sift(keys, 0, i);
+	}
+}
+
+/* Index of the first key which is not less than the given key */
+static int fdt_index_lower_bound(const u64 *keys, int count, u64 key)
+{
+	int lo = 0, hi = count, mid;
+
+	while (lo < hi) {
+		mid = lo + (hi - lo) / 2;
+		if (keys[mid] < key)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	return lo;
+}
+
+static bool fdt_index_usable(const void *fdt)
+{
+	return index_valid &&
+	       fdt_size_dt_struct(fdt) == index_struct_size &&
+	       fdt_size_dt_strings(fdt) == index_strings_size;
+}
+
+void fdt_index_build(const void *fdt)
+{
+	int off, len, slen, depth = 0;
+	const char *compat;
+	u32 phandle;
+
+	fdt_index_invalidate();
+	if (!fdt || fdt_check_header(fdt))
+		return;
+
+	for (off = fdt_next_node(fdt, -1, &depth); off >= 0;
+	     off = fdt_next_node(fdt, off, &depth)) {
+		phandle = fdt_get_phandle(fdt, off);
+		if (phandle) {
+			if (phandle_count >= CONFIG_FDT_INDEX_ENTRIES)
+				return;
+			phandle_keys[phandle_count++] =
+					FDT_INDEX_KEY(phandle, off);
+		}
+
+		compat = fdt_getprop(fdt, off, "compatible", &len);
+		while (compat && len > 0) {
+			if (compat_count >= CONFIG_FDT_INDEX_ENTRIES)
+				return;
+			slen = sbi_strnlen(compat, len) + 1;
+			compat_keys[compat_count++] = FDT_INDEX_KEY(
+					fdt_index_hash(compat, slen), off);
+			compat += slen;
+			len -= slen;
+		}
+	}
+	if (off != -FDT_ERR_NOTFOUND)
+		return;
+
+	fdt_index_sort(phandle_keys, phandle_count);
+	fdt_index_sort(compat_keys, compat_count);
+
+	index_struct_size = fdt_size_dt_struct(fdt);
+	index_strings_size = fdt_size_dt_strings(fdt);
+	index_valid = true;
+}
+
+void fdt_index_invalidate(void)
+{
+	spin_lock(&path_lock);
+	index_valid = false;
+	phandle_count = 0;
+	compat_count = 0;
+	path_count = 0;
+	spin_unlock(&path_lock);
+}
+
+int fdt_index_node_offset_by_phandle(const void *fdt, uint32_t phandle)
+{
+	int i, off;
+
+	if (!fdt_index_usable(fdt) || !phandle || phandle == (uint32_t)-1)
+		return fdt_node_offset_by_phandle(fdt, phandle);
+
+	i = fdt_index_lower_bound(phandle_keys, phandle_count,
+				  FDT_INDEX_KEY(phandle, 0));
+	if (i >= phandle_count || FDT_INDEX_KEY_HI(phandle_keys[i]) != phandle)
+		return -FDT_ERR_NOTFOUND;
+
+	/* Phandles are unique so a match also proves the entry is fresh */
+	off = FDT_INDEX_KEY_OFF(phandle_keys[i]);
+	if (fdt_get_phandle(fdt, off) != phandle) {
+		fdt_index_invalidate();
+		return fdt_node_offset_by_phandle(fdt, phandle);
+	}
+
+	return off;
+}
+
+int fdt_index_node_offset_by_compatible(const void *fdt, int startoffset,
+					const char *compatible)
+{
+	u32 hash;
+	int i, off;
+
+	if (!fdt_index_usable(fdt) || !compatible)
+		return fdt_node_offset_by_compatible(fdt, startoffset,
+						     compatible);
+
+	hash = fdt_index_hash(compatible, sbi_strlen(compatible) + 1);
+	i = fdt_index_lower_bound(compat_keys, compat_count,
+			FDT_INDEX_KEY(hash, startoffset < 0 ? 0 :
+						    startoffset + 1));
+	for (; i < compat_count; i++) {
+		if (FDT_INDEX_KEY_HI(compat_keys[i]) != hash)
+			break;
+		off = FDT_INDEX_KEY_OFF(compat_keys[i]);
+		if (!fdt_node_check_compatible(fdt, off, compatible))
+			return off;
+	}
+
+	return -FDT_ERR_NOTFOUND;
+}
+
+int fdt_index_path_offset(const void *fdt, const char *path)
+{
+	int i, n, off;
+	size_t len;
+	u32 hash;
+
+	if (!fdt_index_usable(fdt) || !path)
+		return fdt_path_offset(fdt, path);
+
+	len = sbi_strlen(path);
+	hash = fdt_index_hash(path, len + 1);
+	n = path_count;
+	smp_rmb();
+	for (i = 0; i < n; i++) {
+		if (path_cache[i].hash == hash &&
+		    !sbi_strcmp(path_cache[i].path, path))
+			return path_cache[i].offset;
+	}
+
+	off = fdt_path_offset(fdt, path);
+	if (off < 0 || len >= FDT_INDEX_PATH_LEN)
+		return off;
+
+	spin_lock(&path_lock);
+	if (index_valid && path_count < FDT_INDEX_PATHS) {
+		path_cache[path_count].hash = hash;
+		path_cache[path_count].offset = off;
+		sbi_memcpy(path_cache[path_count].path, path, len + 1);
+		smp_wmb();
+		path_count++;
+	}
+	spin_unlock(&path_lock);
+
+	return off;
+}
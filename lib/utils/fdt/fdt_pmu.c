@@ -13,6 +13,7 @@
 #include <sbi/sbi_error.h>
 #include <sbi/sbi_pmu.h>
 #include <sbi/sbi_scratch.h>
+#include <sbi_utils/fdt/fdt_fixup.h>
 #include <sbi_utils/fdt/fdt_helper.h>
 #include <sbi_utils/fdt/fdt_pmu.h>
 
@@ -35,25 +36,30 @@ uint64_t fdt_pmu_get_select_value(uint32_t event_idx)
 	return 0;
 }
 
-int fdt_pmu_fixup(void *fdt)
+void fdt_pmu_fixup_node(struct fdt_fixup_pass *pass, int pmu_offset)
 {
-	int pmu_offset;
 	struct sbi_scratch *scratch = sbi_scratch_thishart_ptr();
 
+	fdt_fixup_delprop(pass, pmu_offset, "riscv,event-to-mhpmcounters");
+	fdt_fixup_delprop(pass, pmu_offset, "riscv,event-to-mhpmevent");
+	fdt_fixup_delprop(pass, pmu_offset, "riscv,raw-event-to-mhpmcounters");
+	if (!sbi_hart_has_extension(scratch, SBI_HART_EXT_SSCOFPMF))
+		fdt_fixup_delprop(pass, pmu_offset, "interrupts-extended");
+}
+
+static const struct fdt_fixup_handler fdt_pmu_fixups[] = {
+	{ .compatible = "riscv,pmu", .fixup = fdt_pmu_fixup_node },
+};
+
+int fdt_pmu_fixup(void *fdt)
+{
 	if (!fdt)
 		return SBI_EINVAL;
 
-	pmu_offset = fdt_node_offset_by_compatible(fdt, -1, "riscv,pmu");
-	if (pmu_offset < 0)
+	if (fdt_node_offset_by_compatible(fdt, -1, "riscv,pmu") < 0)
 		return SBI_EFAIL;
 
-	fdt_delprop(fdt, pmu_offset, "riscv,event-to-mhpmcounters");
-	fdt_delprop(fdt, pmu_offset, "riscv,event-to-mhpmevent");
-	fdt_delprop(fdt, pmu_offset, "riscv,raw-event-to-mhpmcounters");
-	if (!sbi_hart_has_extension(scratch, SBI_HART_EXT_SSCOFPMF))
-		fdt_delprop(fdt, pmu_offset, "interrupts-extended");
-
-	return 0;
+	return fdt_fixup_run(fdt, fdt_pmu_fixups, array_size(fdt_pmu_fixups));
 }
 
 int fdt_pmu_setup(void *fdt)
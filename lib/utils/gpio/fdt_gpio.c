@@ -9,12 +9,15 @@
 
 #include <libfdt.h>
 #include <sbi/sbi_error.h>
+#include <sbi_utils/fdt/fdt_driver.h>
 #include <sbi_utils/fdt/fdt_helper.h>
+#include <sbi_utils/fdt/fdt_index.h>
 #include <sbi_utils/gpio/fdt_gpio.h>
 
 /* List of FDT gpio drivers generated at compile time */
 extern struct fdt_gpio *fdt_gpio_drivers[];
 extern unsigned long fdt_gpio_drivers_size;
+extern struct fdt_driver_table fdt_gpio_drivers_table;
 
 static struct fdt_gpio *fdt_gpio_driver(struct gpio_chip *chip)
 {
@@ -33,12 +36,12 @@ static struct fdt_gpio *fdt_gpio_driver(struct gpio_chip *chip)
 
 static int fdt_gpio_init(void *fdt, u32 phandle)
 {
-	int pos, nodeoff, rc;
+	int i, count, nodeoff, rc;
 	struct fdt_gpio *drv;
-	const struct fdt_match *match;
+	struct fdt_driver_hit hits[FDT_DRIVER_MAX_NODE_HITS];
 
 	/* Find node offset */
-	nodeoff = fdt_node_offset_by_phandle(fdt, phandle);
+	nodeoff = fdt_index_node_offset_by_phandle(fdt, phandle);
 	if (nodeoff < 0)
 		return nodeoff;
 
@@ -46,13 +49,14 @@ static int fdt_gpio_init(void *fdt, u32 phandle)
 	if (!fdt_getprop(fdt, nodeoff, "gpio-controller", &rc))
 		return SBI_EINVAL;
 
-	/* Try all GPIO drivers one-by-one */
-	for (pos = 0; pos < fdt_gpio_drivers_size; pos++) {
-		drv = fdt_gpio_drivers[pos];
+	/* Try all matching GPIO drivers one-by-one */
+	count = fdt_driver_match_node(fdt, nodeoff, &fdt_gpio_drivers_table,
+				      hits, array_size(hits));
+	for (i = 0; i < count; i++) {
+		drv = fdt_gpio_drivers[hits[i].pos];
 
-		match = fdt_match_node(fdt, nodeoff, drv->match_table);
-		if (match && drv->init) {
-			rc = drv->init(fdt, nodeoff, phandle, match);
+		if (drv->init) {
+			rc = drv->init(fdt, nodeoff, phandle, hits[i].match);
 			if (rc == SBI_ENODEV)
 				continue;
 			if (rc)
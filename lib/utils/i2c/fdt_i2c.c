@@ -13,25 +13,29 @@
 
 #include <libfdt.h>
 #include <sbi/sbi_error.h>
+#include <sbi_utils/fdt/fdt_driver.h>
 #include <sbi_utils/fdt/fdt_helper.h>
 #include <sbi_utils/i2c/fdt_i2c.h>
 
 /* List of FDT i2c adapter drivers generated at compile time */
 extern struct fdt_i2c_adapter *fdt_i2c_adapter_drivers[];
 extern unsigned long fdt_i2c_adapter_drivers_size;
+extern struct fdt_driver_table fdt_i2c_adapter_drivers_table;
 
 static int fdt_i2c_adapter_init(void *fdt, int nodeoff)
 {
-	int pos, rc;
+	int i, count, rc;
 	struct fdt_i2c_adapter *drv;
-	const struct fdt_match *match;
+	struct fdt_driver_hit hits[FDT_DRIVER_MAX_NODE_HITS];
 
-	/* Try all I2C drivers one-by-one */
-	for (pos = 0; pos < fdt_i2c_adapter_drivers_size; pos++) {
-		drv = fdt_i2c_adapter_drivers[pos];
-		match = fdt_match_node(fdt, nodeoff, drv->match_table);
-		if (match && drv->init) {
-			rc = drv->init(fdt, nodeoff, match);
+	/* Try all matching I2C drivers one-by-one */
+	count = fdt_driver_match_node(fdt, nodeoff,
+				      &fdt_i2c_adapter_drivers_table,
+				      hits, array_size(hits));
+	for (i = 0; i < count; i++) {
+		drv = fdt_i2c_adapter_drivers[hits[i].pos];
+		if (drv->init) {
+			rc = drv->init(fdt, nodeoff, hits[i].match);
 			if (rc == SBI_ENODEV)
 				continue;
 			if (rc)
@@ -8,13 +8,16 @@
  */
 
 #include <sbi/sbi_error.h>
+#include <sbi/sbi_heap.h>
 #include <sbi/sbi_scratch.h>
+#include <sbi_utils/fdt/fdt_driver.h>
 #include <sbi_utils/fdt/fdt_helper.h>
 #include <sbi_utils/ipi/fdt_ipi.h>
 
 /* List of FDT ipi drivers generated at compile time */
 extern struct fdt_ipi *fdt_ipi_drivers[];
 extern unsigned long fdt_ipi_drivers_size;
+extern struct fdt_driver_table fdt_ipi_drivers_table;
 
 static struct fdt_ipi *current_driver = NULL;
 
@@ -33,35 +36,43 @@ static int fdt_ipi_warm_init(void)
 
 static int fdt_ipi_cold_init(void)
 {
-	int pos, noff, rc;
+	int i, count, rc = 0;
 	struct fdt_ipi *drv;
-	const struct fdt_match *match;
+	struct fdt_driver_hit *hits;
 	void *fdt = fdt_get_address();
 
-	for (pos = 0; pos < fdt_ipi_drivers_size; pos++) {
-		drv = fdt_ipi_drivers[pos];
-
-		noff = -1;
-		while ((noff = fdt_find_match(fdt, noff,
-					drv->match_table, &match)) >= 0) {
-			/* drv->cold_init must not be NULL */
-			if (drv->cold_init == NULL)
-				return SBI_EFAIL;
-
-			rc = drv->cold_init(fdt, noff, match);
-			if (rc == SBI_ENODEV)
-				continue;
-			if (rc)
-				return rc;
-			current_driver = drv;
-
-			/*
-			 * We will have multiple IPI devices on multi-die or
-			 * multi-socket systems so we cannot break here.
-			 */
+	count = fdt_driver_scan(fdt, &fdt_ipi_drivers_table, &hits);
+	if (count < 0)
+		return count;
+
+	for (i = 0; i < count; i++) {
+		drv = fdt_ipi_drivers[hits[i].pos];
+
+		/* drv->cold_init must not be NULL */
+		if (drv->cold_init == NULL) {
+			rc = SBI_EFAIL;
+			break;
+		}
+
+		rc = drv->cold_init(fdt, hits[i].nodeoff, hits[i].match);
+		if (rc == SBI_ENODEV) {
+			rc = 0;
+			continue;
 		}
+		if (rc)
+			break;
+		current_driver = drv;
+
+		/*
+		 * We will have multiple IPI devices on multi-die or
+		 * multi-socket systems so we cannot break here.
+		 */
 	}
 
+	sbi_free(hits);
+	if (rc)
+		return rc;
+
 	/*
 	 * On some single-hart system there is no need for ipi,
 	 * so we cannot return a failure here
@@ -8,13 +8,16 @@
  */
 
 #include <sbi/sbi_error.h>
+#include <sbi/sbi_heap.h>
 #include <sbi/sbi_scratch.h>
+#include <sbi_utils/fdt/fdt_driver.h>
 #include <sbi_utils/fdt/fdt_helper.h>
 #include <sbi_utils/irqchip/fdt_irqchip.h>
 
 /* List of FDT irqchip drivers generated at compile time */
 extern struct fdt_irqchip *fdt_irqchip_drivers[];
 extern unsigned long fdt_irqchip_drivers_size;
+extern struct fdt_driver_table fdt_irqchip_drivers_table;
 
 #define FDT_IRQCHIP_MAX_DRIVERS	8
 
@@ -50,38 +53,44 @@ static int fdt_irqchip_warm_init(void)
 static int fdt_irqchip_cold_init(void)
 {
 	bool drv_added;
-	int pos, noff, rc;
+	int i, count, rc = 0;
 	struct fdt_irqchip *drv;
-	const struct fdt_match *match;
+	struct fdt_driver_hit *hits;
 	void *fdt = fdt_get_address();
 
-	for (pos = 0; pos < fdt_irqchip_drivers_size; pos++) {
-		drv = fdt_irqchip_drivers[pos];
-
-		noff = -1;
-		drv_added = false;
-		while ((noff = fdt_find_match(fdt, noff,
-					drv->match_table, &match)) >= 0) {
-			if (drv->cold_init) {
-				rc = drv->cold_init(fdt, noff, match);
-				if (rc == SBI_ENODEV)
-					continue;
-				if (rc)
-					return rc;
-			}
+	count = fdt_driver_scan(fdt, &fdt_irqchip_drivers_table, &hits);
+	if (count < 0)
+		return count;
 
-			if (drv_added)
-				continue;
+	for (i = 0; i < count; i++) {
+		drv = fdt_irqchip_drivers[hits[i].pos];
 
-			current_drivers[current_drivers_count++] = drv;
-			drv_added = true;
+		/* Hits are sorted by driver so only the last one can match */
+		drv_added = current_drivers_count &&
+			    current_drivers[current_drivers_count - 1] == drv;
+		if (!drv_added &&
+		    FDT_IRQCHIP_MAX_DRIVERS <= current_drivers_count)
+			break;
+
+		if (drv->cold_init) {
+			rc = drv->cold_init(fdt, hits[i].nodeoff,
+					    hits[i].match);
+			if (rc == SBI_ENODEV) {
+				rc = 0;
+				continue;
+			}
+			if (rc)
+				break;
 		}
 
-		if (FDT_IRQCHIP_MAX_DRIVERS <= current_drivers_count)
-			break;
+		if (drv_added)
+			continue;
+
+		current_drivers[current_drivers_count++] = drv;
 	}
 
-	return 0;
+	sbi_free(hits);
+	return rc;
 }
 
 int fdt_irqchip_init(bool cold_boot)
@@ -12,8 +12,10 @@
 #include <sbi/riscv_io.h>
 #include <sbi/sbi_error.h>
 #include <sbi/sbi_heap.h>
+#include <sbi/sbi_irqchip.h>
 #include <sbi/sbi_scratch.h>
 #include <sbi_utils/fdt/fdt_helper.h>
+#include <sbi_utils/fdt/fdt_index.h>
 #include <sbi_utils/irqchip/fdt_irqchip.h>
 #include <sbi_utils/irqchip/plic.h>
 
@@ -85,6 +87,41 @@ static int irqchip_plic_warm_init(void)
 				      plic_get_hart_scontext(scratch));
 }
 
+#ifdef CONFIG_SBI_CONSOLE_IRQ
+static int irqchip_plic_external_irqfn(struct sbi_trap_regs *regs)
+{
+	int rc;
+	u32 hwirq;
+	struct sbi_scratch *scratch = sbi_scratch_thishart_ptr();
+	const struct plic_data *plic = plic_get_hart_data_ptr(scratch);
+	long mctx = plic_get_hart_mcontext(scratch);
+
+	if (!plic || mctx < 0)
+		return SBI_ENODEV;
+
+	while ((hwirq = plic_context_claim(plic, mctx))) {
+		rc = sbi_irqchip_process_hwirq(hwirq);
+		plic_context_complete(plic, mctx, hwirq);
+		if (rc)
+			return rc;
+	}
+
+	return 0;
+}
+
+static int irqchip_plic_routefn(u32 hwirq, bool enable)
+{
+	struct sbi_scratch *scratch = sbi_scratch_thishart_ptr();
+	const struct plic_data *plic = plic_get_hart_data_ptr(scratch);
+	long mctx = plic_get_hart_mcontext(scratch);
+
+	if (!plic || mctx < 0)
+		return SBI_ENODEV;
+
+	return plic_context_set_source(plic, mctx, hwirq, enable);
+}
+#endif
+
 static int irqchip_plic_update_hartid_table(void *fdt, int nodeoff,
 					    struct plic_data *pd)
 {
@@ -102,7 +139,8 @@ static int irqchip_plic_update_hartid_table(void *fdt, int nodeoff,
 		phandle = fdt32_to_cpu(val[i]);
 		hwirq = fdt32_to_cpu(val[i + 1]);
 
-		cpu_intc_offset = fdt_node_offset_by_phandle(fdt, phandle);
+		cpu_intc_offset = fdt_index_node_offset_by_phandle(fdt,
+						phandle);
 		if (cpu_intc_offset < 0)
 			continue;
 
@@ -177,6 +215,11 @@ static int irqchip_plic_cold_init(void *fdt, int nodeoff,
 	if (rc)
 		goto fail_free_data;
 
+#ifdef CONFIG_SBI_CONSOLE_IRQ
+	sbi_irqchip_set_irqfn(irqchip_plic_external_irqfn);
+	sbi_irqchip_set_routefn(irqchip_plic_routefn);
+#endif
+
 	return 0;
 
 fail_free_data:
@@ -23,6 +23,7 @@
 #define PLIC_ENABLE_STRIDE 0x80
 #define PLIC_CONTEXT_BASE 0x200000
 #define PLIC_CONTEXT_STRIDE 0x1000
+#define PLIC_CONTEXT_CLAIM 0x4
 
 static u32 plic_get_priority(const struct plic_data *plic, u32 source)
 {
@@ -121,6 +122,52 @@ void plic_context_restore(const struct plic_data *plic, int context_id,
 	plic_set_thresh(plic, context_id, threshold);
 }
 
+u32 plic_context_claim(const struct plic_data *plic, int context_id)
+{
+	volatile void *plic_claim;
+
+	plic_claim = (char *)plic->addr + PLIC_CONTEXT_BASE +
+		     PLIC_CONTEXT_STRIDE * context_id + PLIC_CONTEXT_CLAIM;
+
+	return readl(plic_claim);
+}
+
+void plic_context_complete(const struct plic_data *plic, int context_id,
+			   u32 source)
+{
+	volatile void *plic_claim;
+
+	plic_claim = (char *)plic->addr + PLIC_CONTEXT_BASE +
+		     PLIC_CONTEXT_STRIDE * context_id + PLIC_CONTEXT_CLAIM;
+
+	writel(source, plic_claim);
+}
+
+int plic_context_set_source(const struct plic_data *plic, int context_id,
+			    u32 source, bool enable)
+{
+	u32 ie_value;
+
+	if (!plic || context_id < 0 || !source || plic->num_src < source)
+		return SBI_EINVAL;
+
+	ie_value = plic_get_ie(plic, context_id, source / 32);
+	if (enable)
+		ie_value |= BIT(source % 32);
+	else
+		ie_value &= ~BIT(source % 32);
+	plic_set_ie(plic, context_id, source / 32, ie_value);
+
+	if (enable) {
+		/* Source must have a priority above the context threshold */
+		if (!plic_get_priority(plic, source))
+			plic_set_priority(plic, source, 1);
+		plic_set_thresh(plic, context_id, 0);
+	}
+
+	return 0;
+}
+
 int plic_context_init(const struct plic_data *plic, int context_id,
 		      bool enable, u32 threshold)
 {
@@ -9,25 +9,29 @@
 
 #include <libfdt.h>
 #include <sbi/sbi_error.h>
+#include <sbi_utils/fdt/fdt_driver.h>
 #include <sbi_utils/fdt/fdt_helper.h>
+#include <sbi_utils/fdt/fdt_index.h>
 #include <sbi_utils/regmap/fdt_regmap.h>
 
 /* List of FDT regmap drivers generated at compile time */
 extern struct fdt_regmap *fdt_regmap_drivers[];
 extern unsigned long fdt_regmap_drivers_size;
+extern struct fdt_driver_table fdt_regmap_drivers_table;
 
 static int fdt_regmap_init(void *fdt, int nodeoff, u32 phandle)
 {
-	int pos, rc;
+	int i, count, rc;
 	struct fdt_regmap *drv;
-	const struct fdt_match *match;
-
-	/* Try all I2C drivers one-by-one */
-	for (pos = 0; pos < fdt_regmap_drivers_size; pos++) {
-		drv = fdt_regmap_drivers[pos];
-		match = fdt_match_node(fdt, nodeoff, drv->match_table);
-		if (match && drv->init) {
-			rc = drv->init(fdt, nodeoff, phandle, match);
+	struct fdt_driver_hit hits[FDT_DRIVER_MAX_NODE_HITS];
+
+	/* Try all matching regmap drivers one-by-one */
+	count = fdt_driver_match_node(fdt, nodeoff, &fdt_regmap_drivers_table,
+				      hits, array_size(hits));
+	for (i = 0; i < count; i++) {
+		drv = fdt_regmap_drivers[hits[i].pos];
+		if (drv->init) {
+			rc = drv->init(fdt, nodeoff, phandle, hits[i].match);
 			if (rc == SBI_ENODEV)
 				continue;
 			if (rc)
@@ -71,7 +75,7 @@ int fdt_regmap_get_by_phandle(void *fdt, u32 phandle,
 	if (!fdt || !out_rmap)
 		return SBI_EINVAL;
 
-	pnodeoff = fdt_node_offset_by_phandle(fdt, phandle);
+	pnodeoff = fdt_index_node_offset_by_phandle(fdt, phandle);
 	if (pnodeoff < 0)
 		return pnodeoff;
 
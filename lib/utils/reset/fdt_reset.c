@@ -9,22 +9,21 @@
 
 #include <sbi/sbi_console.h>
 #include <sbi/sbi_error.h>
+#include <sbi/sbi_heap.h>
 #include <sbi/sbi_scratch.h>
+#include <sbi_utils/fdt/fdt_driver.h>
 #include <sbi_utils/fdt/fdt_helper.h>
 #include <sbi_utils/reset/fdt_reset.h>
 
 /* List of FDT reset drivers generated at compile time */
 extern struct fdt_reset *fdt_reset_drivers[];
 extern unsigned long fdt_reset_drivers_size;
+extern struct fdt_driver_table fdt_reset_drivers_table;
 
-int fdt_reset_driver_init(void *fdt, struct fdt_reset *drv)
+static int fdt_reset_node_init(void *fdt, struct fdt_reset *drv, int noff,
+			       const struct fdt_match *match)
 {
-	int noff, rc = SBI_ENODEV;
-	const struct fdt_match *match;
-
-	noff = fdt_find_match(fdt, -1, drv->match_table, &match);
-	if (noff < 0)
-		return SBI_ENODEV;
+	int rc = SBI_ENODEV;
 
 	if (drv->init) {
 		rc = drv->init(fdt, noff, match);
@@ -37,11 +36,32 @@ int fdt_reset_driver_init(void *fdt, struct fdt_reset *drv)
 	return rc;
 }
 
+int fdt_reset_driver_init(void *fdt, struct fdt_reset *drv)
+{
+	int noff;
+	const struct fdt_match *match;
+
+	noff = fdt_find_match(fdt, -1, drv->match_table, &match);
+	if (noff < 0)
+		return SBI_ENODEV;
+
+	return fdt_reset_node_init(fdt, drv, noff, match);
+}
+
 void fdt_reset_init(void)
 {
-	int pos;
+	int i, count;
+	struct fdt_driver_hit *hits;
 	void *fdt = fdt_get_address();
 
-	for (pos = 0; pos < fdt_reset_drivers_size; pos++)
-		fdt_reset_driver_init(fdt, fdt_reset_drivers[pos]);
+	count = fdt_driver_scan(fdt, &fdt_reset_drivers_table, &hits);
+	for (i = 0; i < count; i++) {
+		/* Only the first DT node of each driver is initialized */
+		if (i && hits[i].pos == hits[i - 1].pos)
+			continue;
+		fdt_reset_node_init(fdt, fdt_reset_drivers[hits[i].pos],
+				    hits[i].nodeoff, hits[i].match);
+	}
+
+	sbi_free(hits);
 }
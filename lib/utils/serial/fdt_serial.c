@@ -8,21 +8,43 @@
  */
 
 #include <libfdt.h>
+#include <sbi/sbi_console.h>
 #include <sbi/sbi_error.h>
+#include <sbi/sbi_heap.h>
 #include <sbi/sbi_scratch.h>
+#include <sbi_utils/fdt/fdt_driver.h>
 #include <sbi_utils/fdt/fdt_helper.h>
 #include <sbi_utils/serial/fdt_serial.h>
 
 /* List of FDT serial drivers generated at compile time */
 extern struct fdt_serial *fdt_serial_drivers[];
 extern unsigned long fdt_serial_drivers_size;
+extern struct fdt_driver_table fdt_serial_drivers_table;
+
+static void fdt_serial_setup_irq(void *fdt, int nodeoff)
+{
+	int len;
+	const fdt32_t *val;
+
+	/* Only the first cell of the first interrupt specifier is used */
+	val = fdt_getprop(fdt, nodeoff, "interrupts", &len);
+	if (val && len >= sizeof(fdt32_t)) {
+		sbi_console_set_irq(fdt32_to_cpu(val[0]));
+		return;
+	}
+
+	/* Skip the phandle of the interrupt parent */
+	val = fdt_getprop(fdt, nodeoff, "interrupts-extended", &len);
+	if (val && len >= 2 * sizeof(fdt32_t))
+		sbi_console_set_irq(fdt32_to_cpu(val[1]));
+}
 
 int fdt_serial_init(void)
 {
 	const void *prop;
 	struct fdt_serial *drv;
-	const struct fdt_match *match;
-	int pos, noff = -1, len, coff, rc;
+	struct fdt_driver_hit hits[FDT_DRIVER_MAX_NODE_HITS], *all;
+	int i, count, noff = -1, len, coff, rc;
 	void *fdt = fdt_get_address();
 
 	/* Find offset of node pointed to by stdout-path */
@@ -43,40 +65,51 @@ int fdt_serial_init(void)
 	}
 
 	/* First check DT node pointed by stdout-path */
-	for (pos = 0; pos < fdt_serial_drivers_size && -1 < noff; pos++) {
-		drv = fdt_serial_drivers[pos];
-
-		match = fdt_match_node(fdt, noff, drv->match_table);
-		if (!match)
-			continue;
+	count = (-1 < noff) ? fdt_driver_match_node(fdt, noff,
+				&fdt_serial_drivers_table, hits,
+				array_size(hits)) : 0;
+	for (i = 0; i < count; i++) {
+		drv = fdt_serial_drivers[hits[i].pos];
 
 		/* drv->init must not be NULL */
 		if (drv->init == NULL)
 			return SBI_EFAIL;
 
-		rc = drv->init(fdt, noff, match);
+		rc = drv->init(fdt, noff, hits[i].match);
 		if (rc == SBI_ENODEV)
 			continue;
+		if (!rc)
+			fdt_serial_setup_irq(fdt, noff);
 		return rc;
 	}
 
 	/* Lastly check all DT nodes */
-	for (pos = 0; pos < fdt_serial_drivers_size; pos++) {
-		drv = fdt_serial_drivers[pos];
+	count = fdt_driver_scan(fdt, &fdt_serial_drivers_table, &all);
+	if (count < 0)
+		return count;
 
-		noff = fdt_find_match(fdt, -1, drv->match_table, &match);
-		if (noff < 0)
+	rc = SBI_ENODEV;
+	for (i = 0; i < count; i++) {
+		/* Only the first DT node of each driver is tried */
+		if (i && all[i].pos == all[i - 1].pos)
 			continue;
+		drv = fdt_serial_drivers[all[i].pos];
 
 		/* drv->init must not be NULL */
-		if (drv->init == NULL)
-			return SBI_EFAIL;
+		if (drv->init == NULL) {
+			rc = SBI_EFAIL;
+			break;
+		}
 
-		rc = drv->init(fdt, noff, match);
+		noff = all[i].nodeoff;
+		rc = drv->init(fdt, noff, all[i].match);
 		if (rc == SBI_ENODEV)
 			continue;
-		return rc;
+		if (!rc)
+			fdt_serial_setup_irq(fdt, noff);
+		break;
 	}
 
-	return SBI_ENODEV;
+	sbi_free(all);
+	return rc;
 }
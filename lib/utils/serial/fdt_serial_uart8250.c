@@ -23,7 +23,7 @@ static int serial_uart8250_init(void *fdt, int nodeoff,
 
 	return uart8250_init(uart.addr, uart.freq, uart.baud,
 			     uart.reg_shift, uart.reg_io_width,
-			     uart.reg_offset);
+			     uart.reg_offset, uart.fifo_size);
 }
 
 static const struct fdt_match serial_uart8250_match[] = {
@@ -25,7 +25,15 @@
 #define UART_RXFIFO_EMPTY	0x80000000
 #define UART_RXFIFO_DATA	0x000000ff
 #define UART_TXCTRL_TXEN	0x1
+#define UART_TXCTRL_TXCNT_SHIFT	16
 #define UART_RXCTRL_RXEN	0x1
+#define UART_IP_TXWM		0x1
+#define UART_IE_TXWM		0x1
+#define UART_IE_RXWM		0x2
+
+#define UART_TX_FIFO_DEPTH	8
+/* txwm is pending while the TX FIFO holds fewer than UART_TX_WATERMARK bytes */
+#define UART_TX_WATERMARK	2
 
 /* clang-format on */
 
@@ -74,6 +82,51 @@ static void sifive_uart_putc(char ch)
 	set_reg(UART_REG_TXFIFO, ch);
 }
 
+static unsigned long sifive_uart_puts(const char *str, unsigned long len)
+{
+	u32 room;
+	unsigned long i = 0;
+
+	while (i < len) {
+		/* Wait once for the watermark and then fill the TX FIFO */
+		while (!(get_reg(UART_REG_IP) & UART_IP_TXWM))
+			;
+
+		room = UART_TX_FIFO_DEPTH - (UART_TX_WATERMARK - 1);
+		for (; room && i < len; i++) {
+			if (str[i] == '\n') {
+				if (room < 2)
+					break;
+				set_reg(UART_REG_TXFIFO, '\r');
+				room--;
+			}
+			set_reg(UART_REG_TXFIFO, str[i]);
+			room--;
+		}
+	}
+
+	return len;
+}
+
+static unsigned long sifive_uart_tx_fill(const char *str, unsigned long len)
+{
+	unsigned long i, room;
+
+	if (!(get_reg(UART_REG_IP) & UART_IP_TXWM))
+		return 0;
+
+	room = UART_TX_FIFO_DEPTH - (UART_TX_WATERMARK - 1);
+	for (i = 0; i < len && i < room; i++)
+		set_reg(UART_REG_TXFIFO, str[i]);
+
+	return i;
+}
+
+static void sifive_uart_irq_enable(bool tx, bool rx)
+{
+	set_reg(UART_REG_IE, (tx ? UART_IE_TXWM : 0) | (rx ? UART_IE_RXWM : 0));
+}
+
 static int sifive_uart_getc(void)
 {
 	u32 ret = get_reg(UART_REG_RXFIFO);
@@ -87,7 +140,10 @@ static int sifive_uart_getc(void)
 static struct sbi_console_device sifive_console = {
 	.name = "sifive_uart",
 	.console_putc = sifive_uart_putc,
-	.console_getc = sifive_uart_getc
+	.console_puts = sifive_uart_puts,
+	.console_getc = sifive_uart_getc,
+	.console_tx_fill = sifive_uart_tx_fill,
+	.console_irq_enable = sifive_uart_irq_enable
 };
 
 int sifive_uart_init(unsigned long base, u32 in_freq, u32 baudrate)
@@ -103,8 +159,9 @@ int sifive_uart_init(unsigned long base, u32 in_freq, u32 baudrate)
 	/* Disable interrupts */
 	set_reg(UART_REG_IE, 0);
 
-	/* Enable TX */
-	set_reg(UART_REG_TXCTRL, UART_TXCTRL_TXEN);
+	/* Enable TX and program the TX watermark */
+	set_reg(UART_REG_TXCTRL, UART_TXCTRL_TXEN |
+		(UART_TX_WATERMARK << UART_TXCTRL_TXCNT_SHIFT));
 
 	/* Enable Rx */
 	set_reg(UART_REG_RXCTRL, UART_RXCTRL_RXEN);
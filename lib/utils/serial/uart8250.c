@@ -29,6 +29,13 @@
 #define UART_SCR_OFFSET		7	/* I/O: Scratch Register */
 #define UART_MDR1_OFFSET	8	/* I/O:  Mode Register */
 
+#define UART_IER_RDI		0x01	/* Enable receiver data interrupt */
+#define UART_IER_THRI		0x02	/* Enable transmitter holding register int. */
+
+#define UART_FCR_FIFO_EN	0x01	/* Enable FIFOs */
+
+#define UART_IIR_FIFO_MASK	0xC0	/* FIFO enabled bits */
+
 #define UART_LSR_FIFOE		0x80	/* Fifo error */
 #define UART_LSR_TEMT		0x40	/* Transmitter empty */
 #define UART_LSR_THRE		0x20	/* Transmit-hold-register empty */
@@ -39,6 +46,8 @@
 #define UART_LSR_DR		0x01	/* Receiver data ready */
 #define UART_LSR_BRK_ERROR_BITS	0x1E	/* BI, FE, PE, OE bits */
 
+#define UART_FIFO_SIZE_16550	16	/* TX FIFO depth of 16550 compatibles */
+
 /* clang-format on */
 
 static volatile char *uart8250_base;
@@ -46,6 +55,7 @@ static u32 uart8250_in_freq;
 static u32 uart8250_baudrate;
 static u32 uart8250_reg_width;
 static u32 uart8250_reg_shift;
+static u32 uart8250_fifo_size;
 
 static u32 get_reg(u32 num)
 {
@@ -79,6 +89,53 @@ static void uart8250_putc(char ch)
 	set_reg(UART_THR_OFFSET, ch);
 }
 
+static unsigned long uart8250_puts(const char *str, unsigned long len)
+{
+	u32 room;
+	unsigned long i = 0;
+
+	while (i < len) {
+		/*
+		 * With FIFOs enabled THRE means the whole TX FIFO is
+		 * empty, so wait once and then fill it without polling.
+		 */
+		while ((get_reg(UART_LSR_OFFSET) & UART_LSR_THRE) == 0)
+			;
+
+		for (room = uart8250_fifo_size; room && i < len; i++) {
+			if (str[i] == '\n') {
+				if (room < 2)
+					break;
+				set_reg(UART_THR_OFFSET, '\r');
+				room--;
+			}
+			set_reg(UART_THR_OFFSET, str[i]);
+			room--;
+		}
+	}
+
+	return len;
+}
+
+static unsigned long uart8250_tx_fill(const char *str, unsigned long len)
+{
+	unsigned long i;
+
+	if ((get_reg(UART_LSR_OFFSET) & UART_LSR_THRE) == 0)
+		return 0;
+
+	for (i = 0; i < len && i < uart8250_fifo_size; i++)
+		set_reg(UART_THR_OFFSET, str[i]);
+
+	return i;
+}
+
+static void uart8250_irq_enable(bool tx, bool rx)
+{
+	set_reg(UART_IER_OFFSET, (tx ? UART_IER_THRI : 0) |
+				 (rx ? UART_IER_RDI : 0));
+}
+
 static int uart8250_getc(void)
 {
 	if (get_reg(UART_LSR_OFFSET) & UART_LSR_DR)
@@ -89,11 +146,14 @@ static int uart8250_getc(void)
 static struct sbi_console_device uart8250_console = {
 	.name = "uart8250",
 	.console_putc = uart8250_putc,
-	.console_getc = uart8250_getc
+	.console_puts = uart8250_puts,
+	.console_getc = uart8250_getc,
+	.console_tx_fill = uart8250_tx_fill,
+	.console_irq_enable = uart8250_irq_enable
 };
 
 int uart8250_init(unsigned long base, u32 in_freq, u32 baudrate, u32 reg_shift,
-		  u32 reg_width, u32 reg_offset)
+		  u32 reg_width, u32 reg_offset, u32 fifo_size)
 {
 	u16 bdiv = 0;
 
@@ -123,7 +183,15 @@ int uart8250_init(unsigned long base, u32 in_freq, u32 baudrate, u32 reg_shift,
 	/* 8 bits, no parity, one stop bit */
 	set_reg(UART_LCR_OFFSET, 0x03);
 	/* Enable FIFO */
-	set_reg(UART_FCR_OFFSET, 0x01);
+	set_reg(UART_FCR_OFFSET, UART_FCR_FIFO_EN);
+	/* Use the given FIFO size or detect a 16550 FIFO */
+	if (fifo_size)
+		uart8250_fifo_size = fifo_size;
+	else if ((get_reg(UART_IIR_OFFSET) & UART_IIR_FIFO_MASK) ==
+		 UART_IIR_FIFO_MASK)
+		uart8250_fifo_size = UART_FIFO_SIZE_16550;
+	else
+		uart8250_fifo_size = 1;
 	/* No modem control DTR RTS */
 	set_reg(UART_MCR_OFFSET, 0x00);
 	/* Clear line status */
@@ -8,13 +8,16 @@
  */
 
 #include <sbi/sbi_error.h>
+#include <sbi/sbi_heap.h>
 #include <sbi/sbi_scratch.h>
+#include <sbi_utils/fdt/fdt_driver.h>
 #include <sbi_utils/fdt/fdt_helper.h>
 #include <sbi_utils/timer/fdt_timer.h>
 
 /* List of FDT timer drivers generated at compile time */
 extern struct fdt_timer *fdt_timer_drivers[];
 extern unsigned long fdt_timer_drivers_size;
+extern struct fdt_driver_table fdt_timer_drivers_table;
 
 static struct fdt_timer *current_driver = NULL;
 
@@ -33,35 +36,43 @@ static int fdt_timer_warm_init(void)
 
 static int fdt_timer_cold_init(void)
 {
-	int pos, noff, rc;
+	int i, count, rc = 0;
 	struct fdt_timer *drv;
-	const struct fdt_match *match;
+	struct fdt_driver_hit *hits;
 	void *fdt = fdt_get_address();
 
-	for (pos = 0; pos < fdt_timer_drivers_size; pos++) {
-		drv = fdt_timer_drivers[pos];
-
-		noff = -1;
-		while ((noff = fdt_find_match(fdt, noff,
-					drv->match_table, &match)) >= 0) {
-			/* drv->cold_init must not be NULL */
-			if (drv->cold_init == NULL)
-				return SBI_EFAIL;
-
-			rc = drv->cold_init(fdt, noff, match);
-			if (rc == SBI_ENODEV)
-				continue;
-			if (rc)
-				return rc;
-			current_driver = drv;
-
-			/*
-			 * We will have multiple timer devices on multi-die or
-			 * multi-socket systems so we cannot break here.
-			 */
+	count = fdt_driver_scan(fdt, &fdt_timer_drivers_table, &hits);
+	if (count < 0)
+		return count;
+
+	for (i = 0; i < count; i++) {
+		drv = fdt_timer_drivers[hits[i].pos];
+
+		/* drv->cold_init must not be NULL */
+		if (drv->cold_init == NULL) {
+			rc = SBI_EFAIL;
+			break;
+		}
+
+		rc = drv->cold_init(fdt, hits[i].nodeoff, hits[i].match);
+		if (rc == SBI_ENODEV) {
+			rc = 0;
+			continue;
 		}
+		if (rc)
+			break;
+		current_driver = drv;
+
+		/*
+		 * We will have multiple timer devices on multi-die or
+		 * multi-socket systems so we cannot break here.
+		 */
 	}
 
+	sbi_free(hits);
+	if (rc)
+		return rc;
+
 	/*
 	 * We can't fail here since systems with Sstc might not provide
 	 * mtimer/clint DT node in the device tree.
@@ -82,9 +82,8 @@ static int ariane_final_init(bool cold_boot)
 		return 0;
 
 	fdt = fdt_get_address();
-	fdt_fixups(fdt);
 
-	return 0;
+	return fdt_fixups(fdt);
 }
 
 /*
@@ -97,7 +96,7 @@ static int ariane_console_init(void)
 			     ARIANE_UART_BAUDRATE,
 			     ARIANE_UART_REG_SHIFT,
 			     ARIANE_UART_REG_WIDTH,
-			     ARIANE_UART_REG_OFFSET);
+			     ARIANE_UART_REG_OFFSET, 0);
 }
 
 static int plic_ariane_warm_irqchip_init(int m_cntx_id, int s_cntx_id)
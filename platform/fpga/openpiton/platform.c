@@ -117,9 +117,8 @@ static int openpiton_final_init(bool cold_boot)
 		return 0;
 
 	fdt = fdt_get_address();
-	fdt_fixups(fdt);
 
-	return 0;
+	return fdt_fixups(fdt);
 }
 
 /*
@@ -132,7 +131,8 @@ static int openpiton_console_init(void)
 			     uart.baud,
 			     OPENPITON_DEFAULT_UART_REG_SHIFT,
 			     OPENPITON_DEFAULT_UART_REG_WIDTH,
-			     OPENPITON_DEFAULT_UART_REG_OFFSET);
+			     OPENPITON_DEFAULT_UART_REG_OFFSET,
+			     uart.fifo_size);
 }
 
 static int plic_openpiton_warm_irqchip_init(int m_cntx_id, int s_cntx_id)
@@ -17,9 +17,11 @@
 #include <sbi/sbi_string.h>
 #include <sbi/sbi_system.h>
 #include <sbi/sbi_tlb.h>
+#include <sbi/sbi_trace.h>
 #include <sbi_utils/fdt/fdt_domain.h>
 #include <sbi_utils/fdt/fdt_fixup.h>
 #include <sbi_utils/fdt/fdt_helper.h>
+#include <sbi_utils/fdt/fdt_index.h>
 #include <sbi_utils/fdt/fdt_pmu.h>
 #include <sbi_utils/irqchip/fdt_irqchip.h>
 #include <sbi_utils/irqchip/imsic.h>
@@ -66,6 +68,9 @@ static u32 fw_platform_calculate_heap_size(u32 hart_count)
 	/* For TLB fifo */
 	heap_size += SBI_TLB_INFO_SIZE * (hart_count) * (hart_count);
 
+	/* For trace rings */
+	heap_size += SBI_TRACE_RING_SIZE * hart_count;
+
 	return BIT_ALIGN(heap_size, HEAP_BASE_ALIGN);
 }
 
@@ -95,6 +100,8 @@ unsigned long fw_platform_init(unsigned long arg0, unsigned long arg1,
 	u32 hartid, hart_count = 0;
 	int rc, root_offset, cpus_offset, cpu_offset, len;
 
+	fdt_index_build(fdt);
+
 	root_offset = fdt_path_offset(fdt, "/");
 	if (root_offset < 0)
 		goto fail;
@@ -111,7 +118,7 @@ unsigned long fw_platform_init(unsigned long arg0, unsigned long arg1,
 	if (generic_plat && generic_plat->features)
 		platform.features = generic_plat->features(generic_plat_match);
 
-	cpus_offset = fdt_path_offset(fdt, "/cpus");
+	cpus_offset = fdt_index_path_offset(fdt, "/cpus");
 	if (cpus_offset < 0)
 		goto fail;
 
@@ -183,12 +190,18 @@ static int generic_final_init(bool cold_boot)
 
 	fdt = fdt_get_address();
 
-	fdt_cpu_fixup(fdt);
-	fdt_fixups(fdt);
+	rc = fdt_parse_idle_states(fdt);
+	if (rc)
+		return rc;
+
+	rc = fdt_fixups(fdt);
+	if (rc)
+		return rc;
 	fdt_domain_fixup(fdt);
 
 	if (generic_plat && generic_plat->fdt_fixup) {
 		rc = generic_plat->fdt_fixup(fdt, generic_plat_match);
+		fdt_index_invalidate();
 		if (rc)
 			return rc;
 	}
@@ -124,10 +124,7 @@ static int k210_final_init(bool cold_boot)
 
 	fdt = fdt_get_address();
 
-	fdt_cpu_fixup(fdt);
-	fdt_fixups(fdt);
-
-	return 0;
+	return fdt_fixups(fdt);
 }
 
 static int k210_console_init(void)
@@ -166,9 +166,9 @@ static int ux600_early_init(bool cold_boot)
 	return 0;
 }
 
-static void ux600_modify_dt(void *fdt)
+static int ux600_modify_dt(void *fdt)
 {
-	fdt_fixups(fdt);
+	return fdt_fixups(fdt);
 }
 
 static int ux600_final_init(bool cold_boot)
@@ -179,9 +179,8 @@ static int ux600_final_init(bool cold_boot)
 		return 0;
 
 	fdt = fdt_get_address();
-	ux600_modify_dt(fdt);
 
-	return 0;
+	return ux600_modify_dt(fdt);
 }
 
 static int ux600_console_init(void)
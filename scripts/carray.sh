@@ -61,7 +61,13 @@ if [ -z "${ARRAY_NAME}" ]; then
 	usage
 fi
 
-printf "#include <%s>\n\n" "${TYPE_HEADER}"
+MATCH_MEMBER=`cat ${CONFIG_FILE} | awk '{ if ($1 == "MATCH:") { printf $2; exit 0; } }'`
+
+printf "#include <%s>\n" "${TYPE_HEADER}"
+if [ ! -z "${MATCH_MEMBER}" ]; then
+	printf "#include <sbi_utils/fdt/fdt_driver.h>\n"
+fi
+printf "\n"
 
 for VAR in ${VAR_LIST}; do
 	printf "extern %s %s;\n" "${TYPE_NAME}" "${VAR}"
@@ -75,3 +81,15 @@ done
 printf "};\n\n"
 
 printf "unsigned long %s_size = sizeof(%s) / sizeof(%s *);\n" "${ARRAY_NAME}" "${ARRAY_NAME}" "${TYPE_NAME}"
+
+if [ ! -z "${MATCH_MEMBER}" ]; then
+	printf "\n"
+	printf "static const struct fdt_match *%s_match_table(unsigned long pos)\n" "${ARRAY_NAME}"
+	printf "{\n"
+	printf "\treturn %s[pos]->%s;\n" "${ARRAY_NAME}" "${MATCH_MEMBER}"
+	printf "}\n\n"
+	printf "struct fdt_driver_table %s_table = {\n" "${ARRAY_NAME}"
+	printf "\t.count = sizeof(%s) / sizeof(%s *),\n" "${ARRAY_NAME}" "${TYPE_NAME}"
+	printf "\t.match_table = %s_match_table,\n" "${ARRAY_NAME}"
+	printf "};\n"
+fi
@@ -0,0 +1,145 @@
+#!/usr/bin/env python3
+#
+# SPDX-License-Identifier: BSD-2-Clause
+#
+# Decode OpenSBI binary trace records (CONFIG_SBI_TRACE).
+#
+# Records only carry the offset of their format string from the firmware
+# start, so the firmware ELF is needed to expand them. Input is either a
+# binary buffer filled by the OpenSBI firmware extension TRACE_READ call
+# or a console log containing "sbi_trace:" lines.
+
+import argparse
+import re
+import struct
+import sys
+
+SBI_TRACE_MAGIC = 0x52544253
+SBI_TRACE_MAX_ARGS = 4
+HDR_FMT = '<IIII'
+ENTRY_FMT = '<QII%dQ' % SBI_TRACE_MAX_ARGS
+
+class Elf:
+    def __init__(self, path):
+        with open(path, 'rb') as f:
+            self.data = f.read()
+        if self.data[:4] != b'\x7fELF':
+            sys.exit('%s: not an ELF file' % path)
+        self.is64 = self.data[4] == 2
+        if self.is64:
+            shoff, = struct.unpack_from('<Q', self.data, 0x28)
+            shentsize, shnum = struct.unpack_from('<HH', self.data, 0x3a)
+        else:
+            shoff, = struct.unpack_from('<I', self.data, 0x20)
+            shentsize, shnum = struct.unpack_from('<HH', self.data, 0x2e)
+        self.sections = []
+        for i in range(shnum):
+            off = shoff + i * shentsize
+            if self.is64:
+                name, stype, _, addr, offset, size, link = \
+                    struct.unpack_from('<IIQQQQI', self.data, off)
+            else:
+                name, stype, _, addr, offset, size, link = \
+                    struct.unpack_from('<IIIIIII', self.data, off)
+            self.sections.append((stype, addr, offset, size, link))
+
+    def symbol(self, want):
+        for stype, _, offset, size, link in self.sections:
+            if stype != 2: # SHT_SYMTAB
+                continue
+            stroff = self.sections[link][2]
+            entsize = 24 if self.is64 else 16
+            for off in range(offset, offset + size, entsize):
+                if self.is64:
+                    name, = struct.unpack_from('<I', self.data, off)
+                    value, = struct.unpack_from('<Q', self.data, off + 8)
+                else:
+                    name, value = struct.unpack_from('<II', self.data, off)
+                end = self.data.index(b'\0', stroff + name)
+                if self.data[stroff + name:end].decode() == want:
+                    return value
+        return None
+
+    def string_at(self, addr):
+        for stype, saddr, offset, size, _ in self.sections:
+            if stype == 1 and saddr <= addr < saddr + size: # SHT_PROGBITS
+                start = offset + addr - saddr
+                end = self.data.index(b'\0', start)
+                return self.data[start:end].decode(errors='replace')
+        return None
+
+CONV_RE = re.compile(r'%([-+ #0]*[0-9]*)(?:hh|h|ll|l|z)?([diouxXcps%])')
+
+def expand(fmt, args, xlen):
+    args = list(args)
+    def conv(m):
+        flags, spec = m.group(1), m.group(2)
+        if spec == '%':
+            return '%'
+        # Arguments are recorded as unsigned long zero-extended to u64
+        val = (args.pop(0) if args else 0) & ((1 << xlen) - 1)
+        if spec in 'di':
+            val = val - (1 << xlen) if val & (1 << (xlen - 1)) else val
+            spec = 'd'
+        elif spec in 'ps':
+            spec = 'x'
+        elif spec == 'c':
+            return chr(val & 0xff)
+        return ('%' + flags + spec) % val
+    return CONV_RE.sub(conv, fmt)
+
+def decode(elf, base, hartid, time, fmt, args):
+    text = elf.string_at(base + fmt)
+    if text is None:
+        text = '<unknown format 0x%x>' % fmt
+    else:
+        text = expand(text, args, 64 if elf.is64 else 32).rstrip('\n')
+    print('[%u] %16u: %s' % (hartid, time, text))
+
+def decode_binary(elf, base, data):
+    pos = 0
+    hsize = struct.calcsize(HDR_FMT)
+    esize = struct.calcsize(ENTRY_FMT)
+    while pos + hsize <= len(data):
+        magic, hartid, count, lost = struct.unpack_from(HDR_FMT, data, pos)
+        if magic != SBI_TRACE_MAGIC:
+            sys.exit('bad trace header at offset %d' % pos)
+        pos += hsize
+        if lost:
+            print('[%u] %u records lost' % (hartid, lost))
+        for _ in range(count):
+            e = struct.unpack_from(ENTRY_FMT, data, pos)
+            pos += esize
+            decode(elf, base, hartid, e[0], e[1], e[3:3 + e[2]])
+
+def decode_log(elf, base, lines):
+    for line in lines:
+        idx = line.find('sbi_trace: ')
+        if idx < 0:
+            continue
+        f = line[idx + 11:].split()
+        decode(elf, base, int(f[0]), int(f[1], 16), int(f[2], 16),
+               [int(a, 16) for a in f[3:]])
+
+def main():
+    ap = argparse.ArgumentParser(description='Decode OpenSBI trace records')
+    ap.add_argument('elf', help='firmware ELF (for example fw_dynamic.elf)')
+    ap.add_argument('input', help='binary trace buffer or console log')
+    ap.add_argument('-l', '--log', action='store_true',
+                    help='input is a console log with sbi_trace: lines')
+    args = ap.parse_args()
+
+    elf = Elf(args.elf)
+    base = elf.symbol('_fw_start')
+    if base is None:
+        sys.exit('%s: _fw_start symbol not found' % args.elf)
+
+    if args.log:
+        with open(args.input, errors='replace') as f:
+            decode_log(elf, base, f)
+    else:
+        with open(args.input, 'rb') as f:
+            decode_binary(elf, base, f.read())
+
+if __name__ == '__main__':
+    main()